@@ -10,6 +10,7 @@
 #include <rdmalib/functions.hpp>
 #include <rdmalib/rdmalib.hpp>
 
+#include <rfaas/buffer_pool.hpp>
 #include <rfaas/executor.hpp>
 #include <rfaas/resources.hpp>
 #include <rfaas/rfaas.hpp>
@@ -80,23 +81,24 @@ int main(int argc, char **argv) {
     return 1;
   }
 
-  // FIXME: move me to a memory allocator
-  rdmalib::Buffer<char> in(opts.input_size,
-                           rdmalib::functions::Submission::DATA_HEADER_SIZE),
-      out(opts.input_size);
-  in.register_memory(executor._state.pd(), IBV_ACCESS_LOCAL_WRITE);
-  out.register_memory(executor._state.pd(),
-                      IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
+  rfaas::buffer_pool pool{executor._state.pd()};
+  rfaas::pooled_buffer<char> in = pool.input<char>(opts.input_size),
+                             out = pool.output<char>(opts.input_size);
   memset(in.data(), 0, opts.input_size);
   for (int i = 0; i < opts.input_size; ++i) {
     ((char *)in.data())[i] = 1;
   }
 
+  auto func = executor.function<char, char>(opts.fname);
+  if (!func.valid()) {
+    return 1;
+  }
+
   rdmalib::Benchmarker<1> benchmarker{settings.benchmark.repetitions};
   spdlog::info("Warmups begin");
   for (int i = 0; i < settings.benchmark.warmup_repetitions; ++i) {
     SPDLOG_DEBUG("Submit warm {}", i);
-    executor.execute(opts.fname, in, out);
+    executor.execute(func, in, out);
   }
   spdlog::info("Warmups completed");
 
@@ -104,7 +106,7 @@ int main(int argc, char **argv) {
   for (int i = 0; i < settings.benchmark.repetitions - 1;) {
     benchmarker.start();
     SPDLOG_DEBUG("Submit execution {}", i);
-    auto ret = executor.execute(opts.fname, in, out);
+    auto ret = executor.execute(func, in, out);
     if (std::get<0>(ret)) {
       SPDLOG_DEBUG("Finished execution {} out of {}", i,
                    settings.benchmark.repetitions);
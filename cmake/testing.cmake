@@ -82,3 +82,32 @@ foreach(target ${tests_targets})
 endforeach()
 
 
+
+# Unit tests don't need the executor manager or an RDMA device.
+add_executable(
+  completion_table_test
+  tests/completion_table_test.cpp
+)
+add_executable(
+  resource_manager_db_test
+  tests/resource_manager_db_test.cpp
+  server/resource_manager/db.cpp
+  server/resource_manager/executor.cpp
+)
+add_executable(
+  mailbox_test
+  tests/mailbox_test.cpp
+  server/executor/dispatcher.cpp
+)
+
+set(unit_tests_targets "completion_table_test" "resource_manager_db_test" "mailbox_test")
+foreach(target ${unit_tests_targets})
+  add_dependencies(${target} rfaaslib)
+  target_include_directories(${target} PRIVATE server/)
+  target_include_directories(${target} PRIVATE $<TARGET_PROPERTY:rfaaslib,INTERFACE_INCLUDE_DIRECTORIES>)
+  target_include_directories(${target} PRIVATE $<TARGET_PROPERTY:rdmalib,INTERFACE_INCLUDE_DIRECTORIES>)
+  target_link_libraries(${target} PRIVATE rfaaslib gtest_main)
+  set_target_properties(${target} PROPERTIES RUNTIME_OUTPUT_DIRECTORY tests)
+  # A lost wakeup hangs the test instead of failing it.
+  gtest_discover_tests(${target} PROPERTIES TIMEOUT 60)
+endforeach()
@@ -1,8 +1,10 @@
 
 #include <cstdint>
 
-extern "C" uint32_t empty(void* args, uint32_t size, void* res)
+extern "C" uint32_t empty(void* args, uint32_t size, void* res, uint32_t res_size)
 {
+  if(res_size < sizeof(int))
+    return size;
   int* src = static_cast<int*>(args), *dest = static_cast<int*>(res);
   *dest = *src;
   return size;
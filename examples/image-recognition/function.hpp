@@ -29,16 +29,21 @@ bool load_image(cv::Mat &image) {
   return true;
 }
 
-int recognition(cv::Mat & image) {
+torch::jit::script::Module* load_model() {
 
-  torch::jit::script::Module module;
   try {
-    module = torch::jit::load("resnet50.pt");
+    return new torch::jit::script::Module(torch::jit::load("resnet50.pt"));
   }
   catch (const c10::Error& e) {
     std::cerr << "error loading the model\n";
-    return -1;
+    return nullptr;
   }
+}
+
+int recognition(cv::Mat & image, torch::jit::script::Module* module) {
+
+  if(!module)
+    return -1;
 
 	if (load_image(image)) {
 
@@ -51,7 +56,7 @@ int recognition(cv::Mat & image) {
       input_tensor[0][2] = input_tensor[0][2].sub_(0.406).div_(0.225);
 
 		
-      torch::Tensor out_tensor = module.forward({input_tensor}).toTensor();
+      torch::Tensor out_tensor = module->forward({input_tensor}).toTensor();
      	auto results = out_tensor.sort(-1, true);
       auto softmaxs = std::get<0>(results)[0].softmax(0);
       auto indexs = std::get<1>(results)[0];
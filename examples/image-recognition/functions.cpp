@@ -4,14 +4,27 @@
 
 #include "function.hpp"
 
-extern "C" uint32_t image_recognition(void* args, uint32_t size, void* res)
+// The model is loaded once by each executor thread, not in every invocation.
+extern "C" void* image_recognition_init()
 {
+  return load_model();
+}
+
+extern "C" void image_recognition_finalize(void* state)
+{
+  delete static_cast<torch::jit::script::Module*>(state);
+}
+
+extern "C" uint32_t image_recognition(void* args, uint32_t size, void* res, uint32_t res_size, void* state)
+{
+  if(res_size < sizeof(int))
+    return sizeof(int);
   char* input = static_cast<char*>(args);
   int* output = static_cast<int*>(res);
   std::vector<unsigned char> vectordata(input, input + size);
   cv::Mat image = imdecode(cv::Mat(vectordata), 1);
   cv::Mat image2;
-  *output = recognition(image);
+  *output = recognition(image, static_cast<torch::jit::script::Module*>(state));
   //fprintf(stderr, "%d %d\n", image2.rows, image2.cols);
   //std::vector<unsigned char> out_buffer;
   //cv::imencode(".jpg", image2, out_buffer);
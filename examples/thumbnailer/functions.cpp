@@ -4,7 +4,7 @@
 
 #include "function.hpp"
 
-extern "C" uint32_t thumbnailer(void* args, uint32_t size, void* res)
+extern "C" uint32_t thumbnailer(void* args, uint32_t size, void* res, uint32_t res_size)
 {
   char* input = static_cast<char*>(args);
   char * output = static_cast<char*>(res);
@@ -15,6 +15,8 @@ extern "C" uint32_t thumbnailer(void* args, uint32_t size, void* res)
   //fprintf(stderr, "%d %d\n", image2.rows, image2.cols);
   std::vector<unsigned char> out_buffer;
   cv::imencode(".jpg", image2, out_buffer);
+  if(out_buffer.size() > res_size)
+    return out_buffer.size();
   memcpy(output,out_buffer.data(), out_buffer.size());
   return out_buffer.size();
 }
@@ -7,6 +7,7 @@
 
 #include <cereal/cereal.hpp>
 
+struct ibv_context;
 struct ibv_pd;
 struct ibv_mr;
 struct ibv_sge;
@@ -20,8 +21,23 @@ namespace rdmalib {
     uint32_t r_key;
   };
 
+  // Placement of buffer memory on NUMA nodes, applied before the registration pins the pages.
+  enum class NumaPolicy {
+    // First-touch placement of the kernel.
+    DEFAULT = 0,
+    // Node of the CPU running the registering thread - useful for pinned threads.
+    LOCAL_THREAD,
+    // Node of the RDMA device used for the registration.
+    LOCAL_DEVICE,
+    // Pages interleaved across all nodes.
+    INTERLEAVED
+  };
+
   namespace impl {
 
+    // Failure is not fatal - memory stays with the default placement.
+    bool apply_numa_policy(void* ptr, size_t bytes, NumaPolicy policy, ibv_context* ctx);
+
     // move non-template methods from header
     struct Buffer {
     protected:
@@ -32,10 +48,14 @@ namespace rdmalib {
       void* _ptr;
       ibv_mr* _mr;
       bool _own_memory;
+      bool _own_mr;
+      NumaPolicy _numa_policy;
 
       Buffer();
       Buffer(void* ptr, uint32_t size, uint32_t byte_size);
-      Buffer(uint32_t size, uint32_t byte_size, uint32_t header);
+      // Slice of memory registered elsewhere - we do not deregister it.
+      Buffer(void* ptr, uint32_t size, uint32_t byte_size, uint32_t header, ibv_mr* mr);
+      Buffer(uint32_t size, uint32_t byte_size, uint32_t header, NumaPolicy policy);
       Buffer(Buffer &&);
       Buffer & operator=(Buffer && obj);
       ~Buffer();
@@ -47,6 +67,8 @@ namespace rdmalib {
       uint32_t size() const;
       uint32_t bytes() const;
       void register_memory(ibv_pd *pd, int access);
+      // Applies only to memory owned by the buffer, and only before registration.
+      void set_numa_policy(NumaPolicy policy);
       uint32_t lkey() const;
       uint32_t rkey() const;
       ScatterGatherElement sge(uint32_t size, uint32_t offset) const;
@@ -91,8 +113,14 @@ namespace rdmalib {
       impl::Buffer(ptr, size, sizeof(T))
     {}
 
-    Buffer(size_t size, size_t header = 0):
-      impl::Buffer(size, sizeof(T), header)
+    Buffer(size_t size, size_t header = 0, NumaPolicy policy = NumaPolicy::DEFAULT):
+      impl::Buffer(size, sizeof(T), header, policy)
+    {}
+
+    // Provide a buffer instance for a part of registered memory region
+    // Does NOT free or deregister the associated resource
+    Buffer(void * ptr, uint32_t size, uint32_t header, ibv_mr* mr):
+      impl::Buffer(ptr, size, sizeof(T), header, mr)
     {}
 
     Buffer<T> & operator=(Buffer<T> && obj)
@@ -5,6 +5,8 @@
 #include "rdmalib/queue.hpp"
 #include <cstdint>
 #include <initializer_list>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include <optional>
 
@@ -39,6 +41,15 @@ namespace rdmalib {
     RECV
   };
 
+  // RDMA write with immediate, posted together with other writes.
+  struct WriteRequest {
+    ScatterGatherElement elems;
+    RemoteBuffer rbuf;
+    uint32_t immediate;
+    bool force_inline;
+    bool solicited;
+  };
+
   template<int Key = 8, int UserData = 8, int Secret = 16>
   struct PrivateData {
 
@@ -97,6 +108,11 @@ namespace rdmalib {
     uint32_t _private_data;
   };
 
+  struct Connection;
+
+  // Connections using a shared send completion queue, indexed by QP number.
+  typedef std::unordered_map<uint32_t, Connection*> SendQueueOwners;
+
   // State of a communication:
   // a) communication ID
   // b) Queue Pair
@@ -113,6 +129,22 @@ namespace rdmalib {
     SendWorkCompletions _send_wcs;
     RecvWorkCompletions _rcv_wcs;
     int _send_flags;
+    // Reused to chain work requests of a batch.
+    std::vector<ibv_send_wr> _batch_wrs;
+
+    // Selective signaling - only every Nth send work request generates a completion.
+    // Signaled requests store in wr_id the number of requests they complete,
+    // which allows us to track free entries in the send queue.
+    int _signal_period;
+    int _unsignaled;
+    int _send_outstanding;
+    // Number of all send requests posted so far.
+    uint64_t _send_posted;
+    int _max_send_wr;
+    // Set when the send completion queue is shared - completions of other connections
+    // polled by us are passed to their owners.
+    std::shared_ptr<SendQueueOwners> _send_owners;
+    static constexpr int DEFAULT_MAX_SEND_WR = 40;
 
   public:
     Connection(int rcv_buf_size, bool passive = false);
@@ -127,6 +159,17 @@ namespace rdmalib {
     int rcv_buf_size() const;
 
     void inlining(bool enable);
+    // Signal every Nth send work request, and the last write of each batch.
+    // The default value of 1 signals all requests.
+    // Completions of unsignaled requests cannot be polled - use only when not waiting on specific requests.
+    void signaling(int period);
+    int send_outstanding() const;
+    // Allows to wait for a request without tracking its identifier - returns the
+    // number of send requests posted so far, including the most recent one.
+    uint64_t send_posted() const;
+    // All requests up to the given count have completed.
+    // The last one of them must be signaled, or followed by a signaled request.
+    bool send_finished(uint64_t posted) const;
     void initialize(rdma_cm_id* id);
     void close();
     rdma_cm_id* id() const;
@@ -139,6 +182,11 @@ namespace rdmalib {
 
     // Blocking, no timeout
     std::tuple<ibv_wc*, int> poll_wc(QueueType, bool blocking = true, int count = -1);
+    // Release send queue entries - poll_wc does it for all completions of this connection,
+    // and for completions of connections registered with share_send_queue.
+    void send_completed(const ibv_wc & wc);
+    // Registers the connection as one of the users of a shared send queue.
+    void share_send_queue(std::shared_ptr<SendQueueOwners> owners);
     int32_t post_send(const ScatterGatherElement & elem, int32_t id = -1, bool force_inline = false, std::optional<uint32_t> immediate = std::nullopt);
     int32_t post_recv(ScatterGatherElement && elem, int32_t id = -1, int32_t count = 1);
 
@@ -147,8 +195,13 @@ namespace rdmalib {
     int32_t post_write(ScatterGatherElement && elems, const RemoteBuffer & buf,
       uint32_t immediate,
       bool force_inline = false,
-      bool solicited = false
+      bool solicited = false,
+      bool force_signal = false
     );
+    // Chains all writes into a single ibv_post_send - one doorbell for the entire batch.
+    int32_t post_write_batch(const std::vector<WriteRequest> & requests);
+    // Always signaled - lower 32 bits of completion's wr_id contain the returned id.
+    int32_t post_read(ScatterGatherElement && elems, const RemoteBuffer & buf);
     int32_t post_cas(ScatterGatherElement && elems, const RemoteBuffer & buf, uint64_t compare, uint64_t swap);
     int32_t post_atomic_fadd(ScatterGatherElement && elems, const RemoteBuffer & rbuf, uint64_t add);
 
@@ -157,7 +210,12 @@ namespace rdmalib {
     ibv_cq* wait_events();
     void ack_events(ibv_cq* cq, int len);
   private:
-    int32_t _post_write(ScatterGatherElement && elems, ibv_send_wr wr, bool force_inline, bool force_solicited);
+    int32_t _post_write(ScatterGatherElement && elems, ibv_send_wr wr, bool force_inline, bool force_solicited, bool force_signal);
+    int32_t _post_write_batch(const WriteRequest* requests, int count);
+    // Sets flags of a send request and updates the accounting of send queue.
+    void _signal_request(ibv_send_wr & wr, bool force_inline, bool force_signal);
+    // Waits until the send queue has space for new requests.
+    void _reserve_send(int count);
   };
 }
 
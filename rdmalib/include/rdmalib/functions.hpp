@@ -2,19 +2,80 @@
 #ifndef __RDMALIB_FUNCTIONS_HPP__
 #define __RDMALIB_FUNCTIONS_HPP__
 
+#include <cstdint>
 #include <unordered_map>
 #include <string>
+#include <vector>
 
 namespace rdmalib { namespace functions {
 
+  // Header placed by the client in front of the input data.
+  // The immediate value of the write carries only the index of client's completion slot.
+  // The result is written back with the same slot index, and the status is stored in the highest byte.
   struct Submission {
     uint64_t r_address;
     uint32_t r_key;
-    static constexpr int DATA_HEADER_SIZE = 12;
+    uint32_t func_id;
+    uint64_t invocation_id;
+    uint32_t flags;
+    // Size of client's output buffer.
+    uint32_t r_size;
+    static constexpr int DATA_HEADER_SIZE = 32;
+
+    // The client waits for a completion event and needs a solicited reply.
+    static constexpr uint32_t SOLICITED = 0x1;
+    // Input is not attached - the header is followed by InputDescriptor,
+    // and the executor reads the input from client's memory.
+    static constexpr uint32_t PULL = 0x2;
+    // Several invocations complete in the same slot. They would overwrite each other's
+    // entry in the table of result lengths, and the executor reports only the status.
+    static constexpr uint32_t SHARED_SLOT = 0x4;
+
+    static constexpr uint32_t SLOT_MASK = 0x00FFFFFF;
+    static constexpr int STATUS_SHIFT = 24;
+
+    // Return values sent back to the client.
+    static constexpr uint32_t INPUT_READ_FAILED = 2;
+    static constexpr uint32_t OUTPUT_TOO_LARGE = 3;
+    // Set in the return value when the output was written in multiple chunks.
+    // The total length is written to client's table of result lengths, at the position of completion slot.
+    static constexpr uint32_t LENGTH_REPORTED = 0x80;
   };
+  static_assert(sizeof(Submission) == Submission::DATA_HEADER_SIZE, "Submission header size mismatch");
 
   constexpr int Submission::DATA_HEADER_SIZE;
 
+  // Location of input data for pull-mode invocations.
+  struct InputDescriptor {
+    uint64_t r_address;
+    uint32_t r_key;
+    uint32_t size;
+  };
+
+  // Input buffer of an executor thread, sent to the client after connecting.
+  // The client writes invocations to consecutive slots, and the executor processes
+  // them in the order of arrival. The head is the oldest slot still used by the executor,
+  // and the tail is the next slot written by the client - it's full when the client
+  // has as many invocations in flight as there are slots.
+  struct InputRing {
+    uint64_t r_addr;
+    uint32_t r_key;
+    // Size of each slot, including the submission header.
+    uint32_t slot_size;
+    uint32_t slots;
+    uint32_t head;
+    uint32_t tail;
+  };
+
+  // Optional hooks of function <name> - <name>_init returns the state passed to each invocation,
+  // and <name>_finalize releases it. Hooks cannot be invoked by clients.
+  static constexpr const char* INIT_SUFFIX = "_init";
+  static constexpr const char* FINALIZE_SUFFIX = "_finalize";
+
+  // Removes hooks from the sorted list of symbols. Clients and executors index
+  // functions in the same list. Returns for each function if it has an init hook.
+  std::vector<bool> remove_hooks(std::vector<std::string> & names);
+
 
   typedef void (*FuncType)(void*, void*);
 
@@ -106,6 +106,28 @@ namespace rdmalib {
       return true;
     }
 
+    // Any pollable descriptor, e.g., a process file descriptor or another epoll instance.
+    // Closing the descriptor removes it.
+    bool add_fd(int fd, uint32_t data)
+    {
+      epoll_event ev;
+      ev.events = EPOLLIN;
+      ev.data.u32 = data;
+
+      int ret = epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+      if (ret == -1) {
+        spdlog::error("Failed to add a file descriptor to epoll, fd: {}", fd);
+        return false;
+      }
+
+      return true;
+    }
+
+    int fd() const
+    {
+      return _epoll_fd;
+    }
+
     std::tuple<epoll_event*, int> poll(int timeout_ms)
     {
       int events = epoll_wait(_epoll_fd, _events.data(), MAX_EVENTS, timeout_ms);
@@ -49,6 +49,9 @@ namespace rdmalib {
     RDMAActive & operator=(RDMAActive &&);
     ~RDMAActive();
 
+    // The connection uses an existing receive completion queue.
+    // Must be called before allocating the connection.
+    void share_receive_queue(ibv_cq* cq);
     void allocate();
     bool connect(uint32_t secret = 0);
     void disconnect();
@@ -68,6 +71,8 @@ namespace rdmalib {
     std::unordered_set<Connection*> _active_connections;
 
     std::unordered_map<uint16_t, std::tuple<ibv_comp_channel*, ibv_cq*, ibv_cq*>> _shared_recv_completions;
+    // Connections using each shared send queue.
+    std::unordered_map<uint16_t, std::shared_ptr<SendQueueOwners>> _shared_send_owners;
 
     RDMAPassive(const std::string & ip, int port, int recv_buf = 1, bool initialize = true, int max_inline_data = 0);
     RDMAPassive(RDMAPassive && obj);
@@ -80,7 +85,8 @@ namespace rdmalib {
     uint32_t listen_port() const;
 
     // 0 is reserved value - it's a generic shared queue
-    void register_shared_queue(uint16_t key, bool share_send_queue = false);
+    // Queues are sized for the given number of connections sharing them.
+    void register_shared_queue(uint16_t key, bool share_send_queue = false, int connections = 1);
     std::tuple<ibv_comp_channel*, ibv_cq*, ibv_cq*>* shared_queue(uint16_t key);
 
     // Blocking poll for new rdmacm events.
@@ -1,6 +1,13 @@
 
+#include <cstring>
+#include <fstream>
+#include <string>
+
 // mmap
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/mempolicy.h>
 #include <infiniband/verbs.h>
 
 #include <rdmalib/buffer.hpp>
@@ -8,6 +15,67 @@
 
 namespace rdmalib { namespace impl {
 
+  // Parses the kernel's node list format, e.g., "0-1,3".
+  static void parse_nodelist(const std::string & list, unsigned long* mask, int max_nodes)
+  {
+    size_t pos = 0;
+    while(pos < list.length()) {
+      size_t end = list.find(',', pos);
+      if(end == std::string::npos)
+        end = list.length();
+      std::string range = list.substr(pos, end - pos);
+      size_t dash = range.find('-');
+      int begin = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? begin : std::stoi(range.substr(dash + 1));
+      for(int node = begin; node <= last && node < max_nodes; ++node)
+        mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+      pos = end + 1;
+    }
+  }
+
+  bool apply_numa_policy(void* ptr, size_t bytes, NumaPolicy policy, ibv_context* ctx)
+  {
+    constexpr int MAX_NODES = 1024;
+    constexpr int BITS = 8 * sizeof(unsigned long);
+    unsigned long mask[MAX_NODES / BITS] = {};
+    int mode = MPOL_PREFERRED;
+    int node = -1;
+
+    if(policy == NumaPolicy::DEFAULT) {
+      return true;
+    } else if(policy == NumaPolicy::LOCAL_THREAD) {
+      unsigned cpu = 0, cpu_node = 0;
+      if(syscall(SYS_getcpu, &cpu, &cpu_node, nullptr) == 0)
+        node = cpu_node;
+    } else if(policy == NumaPolicy::LOCAL_DEVICE) {
+      std::ifstream in{std::string{ctx->device->ibdev_path} + "/device/numa_node"};
+      if(!(in >> node))
+        node = -1;
+    } else {
+      mode = MPOL_INTERLEAVE;
+      std::ifstream in{"/sys/devices/system/node/online"};
+      std::string nodes;
+      if(std::getline(in, nodes) && !nodes.empty()) {
+        parse_nodelist(nodes, mask, MAX_NODES);
+        node = 0;
+      }
+    }
+
+    // Unknown node, e.g., on machines without NUMA.
+    if(node < 0 || node >= MAX_NODES)
+      return false;
+    if(mode == MPOL_PREFERRED)
+      mask[node / BITS] |= 1UL << (node % BITS);
+
+    // Pages touched before are migrated.
+    if(syscall(SYS_mbind, ptr, bytes, mode, mask, MAX_NODES, MPOL_MF_MOVE)) {
+      spdlog::warn("Couldn't apply NUMA policy to {} bytes at {}, reason {}", bytes, fmt::ptr(ptr), strerror(errno));
+      return false;
+    }
+    SPDLOG_DEBUG("Applied NUMA policy {} with node {} to {} bytes", static_cast<int>(policy), node, bytes);
+    return true;
+  }
+
   Buffer::Buffer():
     _size(0),
     _header(0),
@@ -15,7 +83,9 @@ namespace rdmalib { namespace impl {
     _byte_size(0),
     _ptr(nullptr),
     _mr(nullptr),
-    _own_memory(false)
+    _own_memory(false),
+    _own_mr(false),
+    _numa_policy(NumaPolicy::DEFAULT)
   {}
 
   Buffer::Buffer(Buffer && obj):
@@ -25,7 +95,9 @@ namespace rdmalib { namespace impl {
     _byte_size(obj._byte_size),
     _ptr(obj._ptr),
     _mr(obj._mr),
-    _own_memory(obj._own_memory)
+    _own_memory(obj._own_memory),
+    _own_mr(obj._own_mr),
+    _numa_policy(obj._numa_policy)
   {
     obj._size = obj._bytes = obj._header = 0;
     obj._ptr = obj._mr = nullptr;
@@ -40,19 +112,23 @@ namespace rdmalib { namespace impl {
     _ptr = obj._ptr;
     _mr = obj._mr;
     _own_memory = obj._own_memory;
+    _own_mr = obj._own_mr;
+    _numa_policy = obj._numa_policy;
 
     obj._size = obj._bytes = 0;
     obj._ptr = obj._mr = nullptr;
     return *this;
   }
 
-  Buffer::Buffer(uint32_t size, uint32_t byte_size, uint32_t header):
+  Buffer::Buffer(uint32_t size, uint32_t byte_size, uint32_t header, NumaPolicy policy):
     _size(size),
     _header(header),
     _bytes(size * byte_size + header),
     _byte_size(byte_size),
     _mr(nullptr),
-    _own_memory(true)
+    _own_memory(true),
+    _own_mr(false),
+    _numa_policy(policy)
   {
     //size_t alloc = _bytes;
     //if(alloc < 4096) {
@@ -74,13 +150,27 @@ namespace rdmalib { namespace impl {
     _byte_size(byte_size),
     _ptr(ptr),
     _mr(nullptr),
-    _own_memory(false)
+    _own_memory(false),
+    _own_mr(false),
+    _numa_policy(NumaPolicy::DEFAULT)
   {
     SPDLOG_DEBUG(
       "Allocated {} bytes, address {}",
       _bytes, fmt::ptr(_ptr)
     );
   }
+
+  Buffer::Buffer(void* ptr, uint32_t size, uint32_t byte_size, uint32_t header, ibv_mr* mr):
+    _size(size),
+    _header(header),
+    _bytes(size * byte_size + header),
+    _byte_size(byte_size),
+    _ptr(ptr),
+    _mr(mr),
+    _own_memory(false),
+    _own_mr(false),
+    _numa_policy(NumaPolicy::DEFAULT)
+  {}
   
   Buffer::~Buffer()
   {
@@ -88,7 +178,7 @@ namespace rdmalib { namespace impl {
       "Deallocate {} bytes, mr {}, ptr {}",
       _bytes, fmt::ptr(_mr), fmt::ptr(_ptr)
     );
-    if(_mr)
+    if(_mr && _own_mr)
       ibv_dereg_mr(_mr);
     if(_own_memory)
       munmap(_ptr, _bytes);
@@ -96,14 +186,23 @@ namespace rdmalib { namespace impl {
 
   void Buffer::register_memory(ibv_pd* pd, int access)
   {
+    // Registration faults in and pins the pages - they must be placed first.
+    if(_own_memory && _numa_policy != NumaPolicy::DEFAULT)
+      apply_numa_policy(_ptr, _bytes, _numa_policy, pd->context);
     _mr = ibv_reg_mr(pd, _ptr, _bytes, access);
     impl::expect_nonnull(_mr);
+    _own_mr = true;
     SPDLOG_DEBUG(
       "Registered {} bytes, mr {}, address {}, lkey {}, rkey {}",
       _bytes, fmt::ptr(_mr), fmt::ptr(_mr->addr), _mr->lkey, _mr->rkey
     );
   }
 
+  void Buffer::set_numa_policy(NumaPolicy policy)
+  {
+    _numa_policy = policy;
+  }
+
   ibv_mr* Buffer::mr() const
   {
     return this->_mr;
@@ -26,7 +26,12 @@ namespace rdmalib {
     _passive(passive),
     _status(ConnectionStatus::UNKNOWN),
     _send_wcs(nullptr),
-    _rcv_wcs(rcv_buf_size, nullptr)
+    _rcv_wcs(rcv_buf_size, nullptr),
+    _signal_period(1),
+    _unsignaled(0),
+    _send_outstanding(0),
+    _send_posted(0),
+    _max_send_wr(DEFAULT_MAX_SEND_WR)
   {
     inlining(false);
 
@@ -49,8 +54,17 @@ namespace rdmalib {
     _status(obj._status),
     _send_wcs(std::move(obj._send_wcs)),
     _rcv_wcs(std::move(obj._rcv_wcs)),
-    _send_flags(obj._send_flags)
+    _send_flags(obj._send_flags),
+    _batch_wrs(std::move(obj._batch_wrs)),
+    _signal_period(obj._signal_period),
+    _unsignaled(obj._unsignaled),
+    _send_outstanding(obj._send_outstanding),
+    _send_posted(obj._send_posted),
+    _max_send_wr(obj._max_send_wr),
+    _send_owners(std::move(obj._send_owners))
   {
+    if(_send_owners && _qp)
+      (*_send_owners)[_qp->qp_num] = this;
     obj._id = nullptr;
     obj._qp = nullptr;
     obj._req_count = 0;
@@ -83,20 +97,89 @@ namespace rdmalib {
     this->_send_wcs.set_qp(id->qp);
     this->_rcv_wcs.set_qp(id->qp);
 
+    ibv_qp_attr attr;
+    ibv_qp_init_attr init_attr;
+    if(!ibv_query_qp(_qp, &attr, IBV_QP_CAP, &init_attr))
+      _max_send_wr = init_attr.cap.max_send_wr;
+
     SPDLOG_DEBUG("Initialize a connection with id {}", fmt::ptr(_id));
   }
 
   void Connection::inlining(bool enable)
   {
     if(enable)
-      _send_flags = IBV_SEND_SIGNALED | IBV_SEND_INLINE;
+      _send_flags = IBV_SEND_INLINE;
     else
-      _send_flags = IBV_SEND_SIGNALED;
+      _send_flags = 0;
+  }
+
+  void Connection::signaling(int period)
+  {
+    // Longer periods could fill the send queue with unsignaled requests only.
+    _signal_period = std::max(1, std::min(period, _max_send_wr / 2));
+  }
+
+  int Connection::send_outstanding() const
+  {
+    return _send_outstanding;
+  }
+
+  uint64_t Connection::send_posted() const
+  {
+    return _send_posted;
+  }
+
+  bool Connection::send_finished(uint64_t posted) const
+  {
+    return _send_posted - _send_outstanding >= posted;
+  }
+
+  void Connection::_signal_request(ibv_send_wr & wr, bool force_inline, bool force_signal)
+  {
+    bool signal = force_signal || _unsignaled + 1 >= _signal_period ||
+      // The request occupying the last entry must be signaled - otherwise we can never reclaim the queue.
+      _send_outstanding + 1 >= _max_send_wr;
+
+    wr.send_flags = force_inline ? IBV_SEND_INLINE : _send_flags;
+    if(signal) {
+      wr.send_flags |= IBV_SEND_SIGNALED;
+      wr.wr_id |= static_cast<uint64_t>(_unsignaled + 1) << 32;
+      _unsignaled = 0;
+    } else {
+      ++_unsignaled;
+    }
+    ++_send_outstanding;
+    ++_send_posted;
+  }
+
+  void Connection::_reserve_send(int count)
+  {
+    while(_send_outstanding + count > _max_send_wr) {
+      SPDLOG_DEBUG("Send queue is full, outstanding requests {}, waiting for completions", _send_outstanding);
+      poll_wc(QueueType::SEND, true);
+    }
+  }
+
+  void Connection::send_completed(const ibv_wc & wc)
+  {
+    uint32_t completed = wc.wr_id >> 32;
+    // Failed requests generate completions even when they're not signaled.
+    _send_outstanding -= completed ? completed : 1;
+  }
+
+  void Connection::share_send_queue(std::shared_ptr<SendQueueOwners> owners)
+  {
+    _send_owners = std::move(owners);
+    (*_send_owners)[_qp->qp_num] = this;
   }
 
   void Connection::close()
   {
     SPDLOG_DEBUG("Connection close called for {} id {}", fmt::ptr(this), fmt::ptr(this->_id));
+    if(_send_owners && _qp) {
+      _send_owners->erase(_qp->qp_num);
+      _send_owners.reset();
+    }
     if(_id) {
       // When the connection is allocated on active side
       // We allocated ep, and that's the only thing we need to do
@@ -156,6 +239,7 @@ namespace rdmalib {
   {
     // FIXME: extend with multiple sges
     struct ibv_send_wr wr, *bad;
+    _reserve_send(1);
     wr.wr_id = id == -1 ? _req_count++ : id;
     wr.next = nullptr;
     wr.sg_list = elems.array();
@@ -164,7 +248,7 @@ namespace rdmalib {
     }
     wr.num_sge = elems.size();
     wr.opcode = immediate.has_value() ? IBV_WR_SEND_WITH_IMM : IBV_WR_SEND;
-    wr.send_flags = force_inline ? IBV_SEND_SIGNALED | IBV_SEND_INLINE : _send_flags;
+    _signal_request(wr, force_inline, false);
     SPDLOG_DEBUG("Post send to local Local QPN {}",_qp->qp_num);
     int ret = ibv_post_send(_qp, &wr, &bad);
     if(ret) {
@@ -211,14 +295,15 @@ namespace rdmalib {
     return wr.wr_id;
   }
 
-  int32_t Connection::_post_write(ScatterGatherElement && elems, ibv_send_wr wr, bool force_inline, bool force_solicited)
+  int32_t Connection::_post_write(ScatterGatherElement && elems, ibv_send_wr wr, bool force_inline, bool force_solicited, bool force_signal)
   {
     ibv_send_wr* bad;
+    _reserve_send(1);
     wr.wr_id = _req_count++;
     wr.next = nullptr;
     wr.sg_list = elems.array();
     wr.num_sge = elems.size();
-    wr.send_flags = force_inline ? IBV_SEND_SIGNALED | IBV_SEND_INLINE : _send_flags;
+    _signal_request(wr, force_inline, force_signal);
     wr.send_flags = force_solicited ? IBV_SEND_SOLICITED | wr.send_flags : wr.send_flags;
 
     if(wr.num_sge == 1 && wr.sg_list[0].length == 0)
@@ -255,10 +340,10 @@ namespace rdmalib {
     wr.opcode = IBV_WR_RDMA_WRITE;
     wr.wr.rdma.remote_addr = rbuf.addr;
     wr.wr.rdma.rkey = rbuf.rkey;
-    return _post_write(std::forward<ScatterGatherElement>(elems), wr, force_inline, false);
+    return _post_write(std::forward<ScatterGatherElement>(elems), wr, force_inline, false, false);
   }
 
-  int32_t Connection::post_write(ScatterGatherElement && elems, const RemoteBuffer & rbuf, uint32_t immediate, bool force_inline, bool force_solicited)
+  int32_t Connection::post_write(ScatterGatherElement && elems, const RemoteBuffer & rbuf, uint32_t immediate, bool force_inline, bool force_solicited, bool force_signal)
   {
     ibv_send_wr wr;
     memset(&wr, 0, sizeof(wr));
@@ -266,19 +351,100 @@ namespace rdmalib {
     wr.imm_data = htonl(immediate);
     wr.wr.rdma.remote_addr = rbuf.addr;
     wr.wr.rdma.rkey = rbuf.rkey;
-    return _post_write(std::forward<ScatterGatherElement>(elems), wr, force_inline, force_solicited);
+    return _post_write(std::forward<ScatterGatherElement>(elems), wr, force_inline, force_solicited, force_signal);
+  }
+
+  int32_t Connection::post_write_batch(const std::vector<WriteRequest> & requests)
+  {
+    // Half of the queue at most - the rest might be occupied by unsignaled requests.
+    int batch_size = std::max(1, _max_send_wr / 2);
+    int32_t ret = _req_count - 1;
+    for(size_t pos = 0; pos < requests.size() && ret != -1; pos += batch_size) {
+      int count = std::min(requests.size() - pos, static_cast<size_t>(batch_size));
+      ret = _post_write_batch(requests.data() + pos, count);
+    }
+    return ret;
+  }
+
+  int32_t Connection::_post_write_batch(const WriteRequest* requests, int count)
+  {
+    _reserve_send(count);
+    _batch_wrs.resize(count);
+    for(int i = 0; i < count; ++i) {
+      const WriteRequest & req = requests[i];
+      ibv_send_wr & wr = _batch_wrs[i];
+      memset(&wr, 0, sizeof(wr));
+      wr.wr_id = _req_count++;
+      wr.next = i + 1 < count ? &_batch_wrs[i + 1] : nullptr;
+      wr.sg_list = req.elems.array();
+      wr.num_sge = req.elems.size();
+      if(wr.num_sge == 1 && wr.sg_list[0].length == 0)
+        wr.num_sge = 0;
+      wr.opcode = IBV_WR_RDMA_WRITE_WITH_IMM;
+      wr.imm_data = htonl(req.immediate);
+      wr.wr.rdma.remote_addr = req.rbuf.addr;
+      wr.wr.rdma.rkey = req.rbuf.rkey;
+      // Unless the period is shorter, only the last request of a batch is signaled.
+      _signal_request(wr, req.force_inline, i + 1 == count);
+      wr.send_flags = req.solicited ? IBV_SEND_SOLICITED | wr.send_flags : wr.send_flags;
+    }
+
+    ibv_send_wr* bad = nullptr;
+    int ret = ibv_post_send(_qp, _batch_wrs.data(), &bad);
+    if(ret) {
+      spdlog::error("Post write batch unsuccesful, reason {} {}, batch size {}, failed at wr_id {}",
+        ret, strerror(ret), count, bad ? bad->wr_id : 0
+      );
+      return -1;
+    }
+    SPDLOG_DEBUG(
+      "Post write batch succesfull, batch size {}, first id {}, local QPN {}",
+      count, _batch_wrs[0].wr_id, _qp->qp_num
+    );
+    return _req_count - 1;
+  }
+
+  int32_t Connection::post_read(ScatterGatherElement && elems, const RemoteBuffer & rbuf)
+  {
+    ibv_send_wr wr, *bad;
+    memset(&wr, 0, sizeof(wr));
+    _reserve_send(1);
+    wr.wr_id = _req_count++;
+    wr.next = nullptr;
+    wr.sg_list = elems.array();
+    wr.num_sge = elems.size();
+    wr.opcode = IBV_WR_RDMA_READ;
+    // Reads are always signaled, the data is available only after completion.
+    _signal_request(wr, false, true);
+    wr.wr.rdma.remote_addr = rbuf.addr;
+    wr.wr.rdma.rkey = rbuf.rkey;
+
+    int ret = ibv_post_send(_qp, &wr, &bad);
+    if(ret) {
+      spdlog::error("Post read unsuccesful, reason {} {}, remote addr {}, remote rkey {}",
+        ret, strerror(ret), wr.wr.rdma.remote_addr, wr.wr.rdma.rkey
+      );
+      return -1;
+    }
+    SPDLOG_DEBUG(
+      "Post read succesfull id: {}, len {}, remote addr {}, remote rkey {}",
+      _req_count - 1, wr.sg_list[0].length, wr.wr.rdma.remote_addr, wr.wr.rdma.rkey
+    );
+    return _req_count - 1;
   }
 
   int32_t Connection::post_cas(ScatterGatherElement && elems, const RemoteBuffer & rbuf, uint64_t compare, uint64_t swap)
   {
     ibv_send_wr wr, *bad;
     memset(&wr, 0, sizeof(wr));
+    _reserve_send(1);
     wr.wr_id = _req_count++;
     wr.next = nullptr;
     wr.sg_list = elems.array();
     wr.num_sge = elems.size();
     wr.opcode = IBV_WR_ATOMIC_CMP_AND_SWP;
-    wr.send_flags = IBV_SEND_SIGNALED;
+    // Atomics are always signaled, the result is available only after completion.
+    _signal_request(wr, false, true);
     wr.wr.atomic.remote_addr = rbuf.addr;
     wr.wr.atomic.rkey = rbuf.rkey;
     wr.wr.atomic.compare_add = compare;
@@ -297,12 +463,13 @@ namespace rdmalib {
   {
     ibv_send_wr wr, *bad;
     memset(&wr, 0, sizeof(wr));
+    _reserve_send(1);
     wr.wr_id = _req_count++;
     wr.next = nullptr;
     wr.sg_list = elems.array();
     wr.num_sge = elems.size();
     wr.opcode = IBV_WR_ATOMIC_FETCH_AND_ADD;
-    wr.send_flags = IBV_SEND_SIGNALED;
+    _signal_request(wr, false, true);
     wr.wr.atomic.remote_addr = rbuf.addr;
     wr.wr.atomic.rkey = rbuf.rkey;
     wr.wr.atomic.compare_add = add;
@@ -345,6 +512,15 @@ namespace rdmalib {
             i+1, ret, wcs[i].status, ibv_wc_status_str(wcs[i].status)
           );
         }
+        if(type == QueueType::SEND) {
+          if(wcs[i].qp_num == _qp->qp_num)
+            send_completed(wcs[i]);
+          else if(_send_owners) {
+            auto it = _send_owners->find(wcs[i].qp_num);
+            if(it != _send_owners->end())
+              it->second->send_completed(wcs[i]);
+          }
+        }
         SPDLOG_DEBUG("Queue {} Ret {}/{} WC {} Status {}", type == QueueType::RECV ? "recv" : "send", i + 1, ret, wcs[i].wr_id, ibv_wc_status_str(wcs[i].status));
       }
     return std::make_tuple(wcs, ret);
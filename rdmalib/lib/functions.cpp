@@ -1,4 +1,6 @@
 
+#include <algorithm>
+
 #include <spdlog/spdlog.h>
 
 #include <rdmalib/functions.hpp>
@@ -7,6 +9,31 @@ namespace rdmalib { namespace functions {
 
   constexpr int Submission::DATA_HEADER_SIZE;
 
+  std::vector<bool> remove_hooks(std::vector<std::string> & names)
+  {
+    auto exists = [&names](const std::string & name) {
+      return std::binary_search(names.begin(), names.end(), name);
+    };
+    // Symbol is a hook only when both the function and its init hook exist.
+    auto is_hook = [&exists](const std::string & name, const std::string & suffix) {
+      if(name.length() <= suffix.length() || name.compare(name.length() - suffix.length(), suffix.length(), suffix))
+        return false;
+      std::string func = name.substr(0, name.length() - suffix.length());
+      return exists(func) && exists(func + INIT_SUFFIX);
+    };
+
+    std::vector<std::string> functions;
+    std::vector<bool> stateful;
+    for(auto & name : names) {
+      if(is_hook(name, INIT_SUFFIX) || is_hook(name, FINALIZE_SUFFIX))
+        continue;
+      functions.push_back(name);
+      stateful.push_back(exists(name + INIT_SUFFIX));
+    }
+    names = std::move(functions);
+    return stateful;
+  }
+
   void FunctionsDB::test_function(void* args, void* res)
   {
     int* src = static_cast<int*>(args), *dest = static_cast<int*>(res);
@@ -131,7 +131,8 @@ namespace rdmalib {
     _cfg.attr.cap.max_inline_data = max_inline_data;
     // Reliable connection
     _cfg.attr.qp_type = IBV_QPT_RC;
-    _cfg.attr.sq_sig_all = 1;
+    // Connections decide which requests are signaled
+    _cfg.attr.sq_sig_all = 0;
 
     // FIXME: make dependent on the number of parallel workers
     _cfg.conn_param.responder_resources = 4;
@@ -160,6 +161,11 @@ namespace rdmalib {
     SPDLOG_DEBUG("Destroy RDMAActive");
   }
 
+  void RDMAActive::share_receive_queue(ibv_cq* cq)
+  {
+    _cfg.attr.recv_cq = cq;
+  }
+
   void RDMAActive::allocate()
   {
     if(!_conn) {
@@ -283,7 +289,8 @@ namespace rdmalib {
     _cfg.attr.cap.max_recv_sge = 5;
     _cfg.attr.cap.max_inline_data = max_inline_data;
     _cfg.attr.qp_type = IBV_QPT_RC;
-    _cfg.attr.sq_sig_all = 1;
+    // Connections decide which requests are signaled
+    _cfg.attr.sq_sig_all = 0;
 
     // FIXME: make dependent on the number of parallel workers
     _cfg.conn_param.responder_resources = 4;
@@ -306,6 +313,8 @@ namespace rdmalib {
     }
 
     for(auto & [key, value] : _shared_recv_completions) {
+      if(std::get<2>(value))
+        ibv_destroy_cq(std::get<2>(value));
       ibv_destroy_cq(std::get<1>(value));
       ibv_destroy_comp_channel(std::get<0>(value));
     }
@@ -319,7 +328,8 @@ namespace rdmalib {
     _pd(std::move(obj._pd)),
     _recv_buf(obj._recv_buf),
     _active_connections(std::move(obj._active_connections)),
-    _shared_recv_completions(std::move(obj._shared_recv_completions))
+    _shared_recv_completions(std::move(obj._shared_recv_completions)),
+    _shared_send_owners(std::move(obj._shared_send_owners))
   {
     obj._ec = nullptr;
     obj._listen_id = nullptr;
@@ -335,6 +345,7 @@ namespace rdmalib {
     _pd = std::move(obj._pd);
     _active_connections = std::move(obj._active_connections);
     _shared_recv_completions = std::move(obj._shared_recv_completions);
+    _shared_send_owners = std::move(obj._shared_send_owners);
 
     obj._ec = nullptr;
     obj._listen_id = nullptr;
@@ -484,6 +495,9 @@ namespace rdmalib {
           if(!std::get<1>((*it).second)) {
             std::get<1>((*it).second) = connection->qp()->recv_cq;
           }
+          // Completions of other connections can be polled by anyone waiting for the send queue.
+          if(std::get<2>((*it).second))
+            connection->share_send_queue(_shared_send_owners[(*it).first]);
         }
 
         status = ConnectionStatus::REQUESTED;
@@ -531,13 +545,15 @@ namespace rdmalib {
     return std::make_tuple(connection, status);
   }
 
-  void RDMAPassive::register_shared_queue(uint16_t key, bool share_send_queue)
+  void RDMAPassive::register_shared_queue(uint16_t key, bool share_send_queue, int connections)
   {
     ibv_comp_channel* channel = ibv_create_comp_channel(_pd->context);
-    ibv_cq* cq = ibv_create_cq(_pd->context, _cfg.attr.cap.max_recv_wr, nullptr, channel, 0);
+    ibv_cq* cq = ibv_create_cq(_pd->context, _cfg.attr.cap.max_recv_wr * connections, nullptr, channel, 0);
     ibv_cq* send_cq = nullptr;
     if(share_send_queue) {
-      send_cq = ibv_create_cq(_pd->context, _cfg.attr.cap.max_send_wr, nullptr, channel, 0);
+      // Each connection can have all entries of its send queue outstanding.
+      send_cq = ibv_create_cq(_pd->context, _cfg.attr.cap.max_send_wr * connections, nullptr, channel, 0);
+      _shared_send_owners[key] = std::make_shared<SendQueueOwners>();
     }
 
     _shared_recv_completions[key] = std::make_tuple(channel, cq, send_cq);
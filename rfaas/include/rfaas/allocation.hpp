@@ -2,7 +2,10 @@
 #ifndef __RFAAS_ALLOCATION_HPP__
 #define __RFAAS_ALLOCATION_HPP__
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 namespace rfaas {
 
@@ -13,20 +16,26 @@ namespace rfaas {
     int32_t memory;
   };
 
+  // Lease is split across nodes when a single node doesn't have enough free cores.
+  static constexpr int MAX_NODES_PER_LEASE = 8;
+
+  // Each node allocates its part of the lease independently.
   struct LeasedNode {
+    int32_t lease_id;
     int32_t port;
     int16_t cores;
     char address[16];
   };
 
   struct LeaseResponse {
-
-    int32_t lease_id;
-    int32_t port;
-    char address[16];
-    //LeasedNode nodes[MAX_NODES_PER_LEASE];
+    int16_t nodes_count;
+    LeasedNode nodes[MAX_NODES_PER_LEASE];
   };
 
+  // SHA-256 of the functions library.
+  static constexpr int LIBRARY_DIGEST_SIZE = 32;
+  typedef std::array<uint8_t, LIBRARY_DIGEST_SIZE> LibraryDigest;
+
   struct AllocationRequest {
     // > 0: Lease identificator
     // < 0: client_id with negative sign, deallocation & disconnect request
@@ -43,8 +52,17 @@ namespace rfaas {
     // Legacy support for skipping resource manager
     int16_t cores = 0;
     int32_t memory = 0;
+
+    // Functions library is identified by its content.
+    // The manager reads the library from the client only when it's not cached.
+    // The cache is shared by all clients - the digest must be collision resistant.
+    LibraryDigest func_digest = {};
+    uint64_t func_addr = 0;
+    uint32_t func_rkey = 0;
   };
 
+  LibraryDigest library_digest(const void* data, size_t size);
+
   struct LeaseStatus {
     static constexpr int ALLOCATED = 0;
     static constexpr int UNKNOWN = 1;
@@ -0,0 +1,163 @@
+
+#ifndef __RFAAS_BUFFER_POOL_HPP__
+#define __RFAAS_BUFFER_POOL_HPP__
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <infiniband/verbs.h>
+
+#include <rdmalib/buffer.hpp>
+#include <rdmalib/functions.hpp>
+
+namespace rfaas {
+
+  struct buffer_pool;
+
+  // Part of a registered arena.
+  struct pool_block {
+    void* ptr;
+    ibv_mr* mr;
+  };
+
+  // Buffer returned to its pool on destruction.
+  // It can be passed to every interface expecting rdmalib::Buffer<T>.
+  template<typename T>
+  struct pooled_buffer : rdmalib::Buffer<T> {
+
+    pooled_buffer():
+      _pool(nullptr),
+      _size_class(-1),
+      _block{nullptr, nullptr}
+    {}
+
+    pooled_buffer(buffer_pool* pool, int size_class, pool_block block, uint32_t size, uint32_t header):
+      rdmalib::Buffer<T>(block.ptr, size, header, block.mr),
+      _pool(pool),
+      _size_class(size_class),
+      _block(block)
+    {}
+
+    ~pooled_buffer()
+    {
+      release();
+    }
+
+    pooled_buffer(const pooled_buffer &) = delete;
+    pooled_buffer& operator=(const pooled_buffer &) = delete;
+
+    pooled_buffer(pooled_buffer && obj):
+      rdmalib::Buffer<T>(std::move(obj)),
+      _pool(obj._pool),
+      _size_class(obj._size_class),
+      _block(obj._block)
+    {
+      obj._pool = nullptr;
+    }
+
+    pooled_buffer& operator=(pooled_buffer && obj)
+    {
+      if(this != &obj) {
+        release();
+        rdmalib::Buffer<T>::operator=(std::move(obj));
+        _pool = obj._pool;
+        _size_class = obj._size_class;
+        _block = obj._block;
+        obj._pool = nullptr;
+      }
+      return *this;
+    }
+
+    void release();
+
+  private:
+    buffer_pool* _pool;
+    int _size_class;
+    pool_block _block;
+  };
+
+  // Allocator of RDMA-registered buffers for invocation inputs and outputs.
+  // Memory is registered in large arenas only once, and split into
+  // power-of-two size classes. Each thread keeps a small cache of free blocks;
+  // the shared free lists are used only when the cache is empty or full.
+  // Requests larger than the biggest class get a dedicated registration.
+  struct buffer_pool {
+    static constexpr int MIN_CLASS_SHIFT = 8;
+    static constexpr int MAX_CLASS_SHIFT = 22;
+    static constexpr int NUM_CLASSES = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1;
+    static constexpr size_t ARENA_SIZE = 1 << 24;
+    static constexpr size_t THREAD_CACHE_SIZE = 32;
+    // Remote reads are needed for inputs pulled by the executor.
+    static constexpr int DEFAULT_ACCESS = IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE | IBV_ACCESS_REMOTE_READ;
+
+    // The NUMA policy is applied to arenas and separate buffers before their registration.
+    buffer_pool(ibv_pd* pd, int access = DEFAULT_ACCESS, rdmalib::NumaPolicy policy = rdmalib::NumaPolicy::DEFAULT);
+    ~buffer_pool();
+
+    buffer_pool(const buffer_pool &) = delete;
+    buffer_pool& operator=(const buffer_pool &) = delete;
+
+    // Input buffers reserve space for the submission header.
+    template<typename T>
+    pooled_buffer<T> input(uint32_t size)
+    {
+      return acquire<T>(size, rdmalib::functions::Submission::DATA_HEADER_SIZE);
+    }
+
+    template<typename T>
+    pooled_buffer<T> output(uint32_t size)
+    {
+      return acquire<T>(size, 0);
+    }
+
+    template<typename T>
+    pooled_buffer<T> acquire(uint32_t size, uint32_t header)
+    {
+      size_t bytes = size * sizeof(T) + header;
+      int size_class = class_of(bytes);
+      return pooled_buffer<T>{this, size_class, acquire_block(size_class, bytes), size, header};
+    }
+
+    void release(int size_class, pool_block block);
+    // Total size of registered arenas.
+    size_t registered() const;
+
+  private:
+    struct free_list {
+      std::mutex lock;
+      std::vector<pool_block> free;
+    };
+
+    ibv_pd* _pd;
+    int _access;
+    rdmalib::NumaPolicy _numa_policy;
+    uint64_t _id;
+    std::array<free_list, NUM_CLASSES> _classes;
+    mutable std::mutex _arenas_lock;
+    std::vector<rdmalib::Buffer<char>> _arenas;
+    size_t _registered;
+
+    static int class_of(size_t bytes);
+    pool_block acquire_block(int size_class, size_t bytes);
+    // Moves blocks between the shared list and the thread cache.
+    void refill(int size_class, std::vector<pool_block> & cache);
+    void flush(int size_class, std::vector<pool_block> & cache);
+    void allocate_arena(int size_class);
+    std::vector<pool_block>& thread_cache(int size_class);
+  };
+
+  template<typename T>
+  void pooled_buffer<T>::release()
+  {
+    if(_pool) {
+      _pool->release(_size_class, _block);
+      _pool = nullptr;
+    }
+  }
+
+}
+
+#endif
+
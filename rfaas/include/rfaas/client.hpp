@@ -53,15 +53,11 @@ namespace rfaas {
         return std::nullopt;
       }
 
+      // The lease could have been split across several nodes.
       int response_id = responses[0].wr_id;
-      return rfaas::executor{
-        std::string{_resource_mgr.response(response_id).address},
-        _resource_mgr.response(response_id).port,
-        cores,
-        memory,
-        _resource_mgr.response(response_id).lease_id,
-        dev
-      };
+      const rfaas::LeaseResponse & response = _resource_mgr.response(response_id);
+      std::vector<LeasedNode> nodes{response.nodes, response.nodes + response.nodes_count};
+      return std::make_optional<rfaas::executor>(nodes, memory, dev);
     }
 
     std::optional<rfaas::executor> lease(servers & nodes_data, int16_t cores, int32_t memory)
@@ -70,9 +66,29 @@ namespace rfaas {
         return std::nullopt;
       }
 
-      server_data instance = nodes_data.server(0);
+      // Without the resource manager, take cores from consecutive servers.
+      std::vector<LeasedNode> nodes;
+      int remaining = cores;
+      for(size_t i = 0; i < nodes_data.size() && remaining > 0; ++i) {
+
+        server_data instance = nodes_data.server(i);
+        if(static_cast<int>(nodes.size()) == MAX_NODES_PER_LEASE)
+          break;
+
+        // Legacy data without core count - the first server takes everything.
+        int node_cores = instance.cores > 0 ? std::min(remaining, static_cast<int>(instance.cores)) : remaining;
+        LeasedNode node{0, instance.port, static_cast<int16_t>(node_cores), ""};
+        strncpy(node.address, instance.address.c_str(), sizeof(node.address) - 1);
+        nodes.push_back(node);
+        remaining -= node_cores;
+      }
+
+      if(remaining > 0) {
+        spdlog::error("Servers don't have enough cores to allocate {} threads", cores);
+        return std::nullopt;
+      }
 
-      return std::make_optional<rfaas::executor>(instance.address, instance.port, cores, memory, 0, _device);
+      return std::make_optional<rfaas::executor>(nodes, memory, _device);
     }
 
   private:
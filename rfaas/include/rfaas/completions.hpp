@@ -0,0 +1,127 @@
+
+#ifndef __RFAAS_COMPLETIONS_HPP__
+#define __RFAAS_COMPLETIONS_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+
+namespace rfaas {
+
+  struct completion_slot {
+    // Owners of the slot: the submitted invocation and its future.
+    // The slot can be reused once both of them released it.
+    std::atomic<int> references;
+    // Completions the invocation is still waiting for.
+    // Threads waiting for the result are parked on this value.
+    std::atomic<int> remaining;
+    std::atomic<int> waiters;
+    // First non-zero return value, or zero when all completions succeeded.
+    std::atomic<int> result;
+    // Bytes written to the output buffer by the last completion.
+    std::atomic<uint32_t> bytes;
+    // Callback registered by the owner of the future, e.g., to resume a coroutine.
+    // It is invoked by the thread that polled the last completion.
+    std::atomic<int> continuation_state;
+    void (*continuation)(void*);
+    void* continuation_data;
+  };
+
+  // Lightweight replacement of std::future - the state lives in a preallocated slot.
+  struct future {
+    future(completion_slot* slot = nullptr);
+    ~future();
+
+    future(const future &) = delete;
+    future& operator=(const future &) = delete;
+    future(future && obj);
+    future& operator=(future && obj);
+
+    bool valid() const;
+    bool is_ready() const;
+    // Spins for a short time before parking the thread until the result arrives.
+    void wait() const;
+    // Returns the result of invocation and releases the slot.
+    int get();
+    // Registers a callback invoked once the invocation is finished.
+    // Returns false when the invocation has already finished - the callback will not be called.
+    bool on_completion(void (*callback)(void*), void* data);
+    // Size of the output, valid when the invocation is finished.
+    uint32_t bytes() const;
+
+  private:
+    void release();
+
+    completion_slot* _slot;
+  };
+
+  // Awaitable wrapper of a future, resumed by the thread polling the completion.
+  // Does not depend on <coroutine> - any coroutine handle type providing
+  // address() and from_address() can be used, e.g., std::coroutine_handle in C++20.
+  struct awaitable_result {
+    awaitable_result(future && result):
+      _result(std::move(result))
+    {}
+
+    bool await_ready() const
+    {
+      return !_result.valid() || _result.is_ready();
+    }
+
+    template<typename Handle>
+    bool await_suspend(Handle handle)
+    {
+      return _result.on_completion(&awaitable_result::resume<Handle>, handle.address());
+    }
+
+    // Returns success and the size of the output.
+    std::tuple<bool, int> await_resume()
+    {
+      if(!_result.valid())
+        return std::make_tuple(false, 0);
+      uint32_t bytes = _result.bytes();
+      return std::make_tuple(_result.get() == 0, bytes);
+    }
+
+  private:
+    template<typename Handle>
+    static void resume(void* address)
+    {
+      Handle::from_address(address).resume();
+    }
+
+    future _result;
+  };
+
+  // Fixed-capacity ring of completion slots.
+  // Slot index is sent with the invocation and returned in its completion.
+  struct completion_table {
+    static constexpr int DEFAULT_CAPACITY = 1024;
+
+    // Throws std::invalid_argument when the capacity is not a power of two fitting the slot mask.
+    completion_table(int capacity = DEFAULT_CAPACITY);
+
+    completion_table(completion_table && obj);
+    completion_table& operator=(completion_table && obj);
+
+    // Returns -1 when all slots are in use.
+    int acquire(int completions);
+    // Returns true when it was the last completion of the invocation.
+    bool complete(int slot, int result, uint32_t bytes);
+    // Invokes the continuation of finished invocation, if there's one, and releases the slot.
+    // Must be called for each finished invocation without holding locks needed by continuations.
+    void resume(int slot);
+    completion_slot* slot(int idx) const;
+    int capacity() const;
+
+  private:
+    int _capacity;
+    std::atomic<uint32_t> _head;
+    std::unique_ptr<completion_slot[]> _slots;
+  };
+
+}
+
+#endif
+
@@ -32,6 +32,9 @@ namespace rfaas {
     bool connect();
     void disconnect();
     bool submit();
+    // Split submission allows to send requests to many managers before waiting.
+    void send_request();
+    bool receive_response();
     LeaseStatus* poll_response();
   };
 
@@ -3,15 +3,22 @@
 #define __RFAAS_EXECUTOR_HPP__
 
 #include <algorithm>
+#include <array>
+#include <deque>
 #include <iterator>
 #include <future>
+#include <mutex>
+#include <unordered_map>
 #include <fcntl.h>
 
 #include <rdmalib/benchmarker.hpp>
 #include <rdmalib/connection.hpp>
 #include <rdmalib/buffer.hpp>
+#include <rdmalib/functions.hpp>
+#include <rdmalib/poller.hpp>
 #include <rdmalib/rdmalib.hpp>
 
+#include <rfaas/completions.hpp>
 #include <rfaas/connection.hpp>
 #include <rfaas/devices.hpp>
 
@@ -40,40 +47,132 @@ namespace rfaas {
     operator int() const;
   };
 
+  // Counters of the background thread processing asynchronous completions.
+  struct polling_statistics {
+    // Completions processed while spinning, and after waking up from sleep.
+    uint64_t hot_completions;
+    uint64_t warm_completions;
+    // Number of times the thread was woken up by a completion event.
+    uint64_t wakeups;
+    // Time spent spinning, and CPU time consumed by the thread, in nanoseconds.
+    uint64_t spin_time;
+    uint64_t cpu_time;
+  };
+
+  // Updated by the background thread, read by the user.
+  struct polling_counters {
+    std::atomic<uint64_t> hot_completions;
+    std::atomic<uint64_t> warm_completions;
+    std::atomic<uint64_t> wakeups;
+    std::atomic<uint64_t> spin_time;
+    std::atomic<uint64_t> cpu_time;
+
+    polling_counters();
+    polling_counters(const polling_counters & obj);
+    polling_counters& operator=(const polling_counters & obj);
+
+    polling_statistics load() const;
+  };
+
   struct executor_state {
     std::unique_ptr<rdmalib::Connection> conn;
+    // Ring of input slots - invocations are written at the tail,
+    // and the executor returns results in the order of slots.
     rdmalib::RemoteBuffer remote_input;
+    uint32_t input_slot_size;
+    int input_slots;
+    // Counts all submissions - the slot is the remainder of division by the number of slots.
+    uint64_t input_tail;
+    // Invocations submitted to this executor thread that did not return yet.
+    // We stop at the size of the ring, or earlier if we can't receive that many results.
+    int outstanding;
+    int max_outstanding;
     //rdmalib::RecvBuffer _rcv_buffer;
     executor_state(rdmalib::Connection*, int rcv_buf_size);
   };
 
+  // Function resolved once after loading the library.
+  // Input and output types are checked at compile time when invoking.
+  template<typename T, typename U>
+  struct function_handle {
+    int index;
+
+    function_handle(int index = -1):
+      index(index)
+    {}
+
+    bool valid() const
+    {
+      return index >= 0;
+    }
+  };
+
+  // Invocation waiting on the client side until one of executor threads becomes idle.
+  struct pending_invocation {
+    rdmalib::ScatterGatherElement sge;
+    // Index of completion slot - sent as the immediate value.
+    uint32_t slot;
+    bool solicited;
+    // Non-empty for inputs read by the executor.
+    rdmalib::functions::InputDescriptor input;
+  };
+
   struct executor {
-    static constexpr int MAX_REMOTE_WORKERS = 64;
+    // Upper bound on invocations queued at a single executor thread.
+    static constexpr int MAX_INPUT_SLOTS = 16;
+    // Only every Nth invocation write generates a send completion.
+    static constexpr int SEND_SIGNALING_PERIOD = 16;
+    // Must not exceed the capacity of rdmalib::Poller.
+    static constexpr int MAX_POLLED_COMPLETIONS = 64;
     rdmalib::RDMAPassive _state;
-    rdmalib::Buffer<rdmalib::BufferInformation> _execs_buf;
+    rdmalib::Buffer<rdmalib::functions::InputRing> _execs_buf;
 
     device_data _device;
 
     int _numcores;
     int _memory;
     int _executions;
-    int _invoc_id;
-    int _lease_id;
+    // Larger inputs are not sent - executor threads read them from our memory.
+    int _max_input_size;
+    std::atomic<uint64_t> _invoc_id;
+    // Lease can span several nodes - threads from all nodes connect to us,
+    // and invocations are dispatched across all of them.
+    std::vector<LeasedNode> _nodes;
     // FIXME: global settings
     std::vector<executor_state> _connections;
-    std::unique_ptr<manager_connection> _exec_manager;
+    std::vector<std::unique_ptr<manager_connection>> _exec_managers;
     std::vector<std::string> _func_names;
 
     // manage async executions
     std::atomic<bool> _end_requested;
     std::atomic<bool> _active_polling;
-    //std::unordered_map<int, std::promise<int>> _futures;
-    std::unordered_map<int, std::tuple<int, std::promise<int>>> _futures;
+    // The background thread spins for the timeout (in microseconds) after the last
+    // completion, and then sleeps until the next completion event.
+    polling_type _polling;
+    polling_counters _polling_counters;
+    completion_table _completions;
     std::unique_ptr<std::thread> _background_thread;
     int events;
 
+    // Dispatching invocations across executor threads.
+    // The mutex protects pending queue and counters of outstanding invocations,
+    // since completions are processed both by the user and the background thread.
+    std::mutex _dispatch_mutex;
+    std::deque<pending_invocation> _pending;
+    std::unordered_map<uint32_t, int> _qp_to_conn;
+    int _next_conn;
+    // All connections share the receive queue.
+    rdmalib::Poller _poller;
+    // Descriptors of pull-mode inputs, one for each input slot of executor threads.
+    rdmalib::Buffer<rdmalib::functions::InputDescriptor> _descriptors;
+    // Executor threads write here the length of outputs transferred in chunks,
+    // one entry for each completion slot.
+    rdmalib::Buffer<uint32_t> _result_lengths;
+    rdmalib::Buffer<rdmalib::BufferInformation> _result_lengths_info;
+
     // Currently, we use the same device for listening and connecting to the manager.
     executor(const std::string& address, int port, int numcores, int memory, int lease_id, device_data & dev);
+    executor(const std::vector<LeasedNode> & nodes, int memory, device_data & dev);
     ~executor();
 
     executor(executor&& obj);
@@ -84,114 +183,216 @@ namespace rfaas {
     // Skipping managers is useful for benchmarking
     bool allocate(std::string functions_path, int max_input_size, int hot_timeout,
         bool skip_manager = false, bool skip_resource_manager = false, rdmalib::Benchmarker<5> * benchmarker = nullptr);
+    // Allocation in a separate thread - the executor must not be used until the future is ready.
+    std::future<bool> allocate_async(std::string functions_path, int max_input_size, int hot_timeout,
+        bool skip_manager = false, bool skip_resource_manager = false);
+    // Allocates all executors concurrently, overlapping their cold starts.
+    // Returns the allocation result of each executor.
+    static std::vector<bool> allocate(const std::vector<executor*> & executors, std::string functions_path,
+        int max_input_size, int hot_timeout, bool skip_manager = false, bool skip_resource_manager = false);
     void deallocate();
     rdmalib::Buffer<char> load_library(std::string path);
     void poll_queue();
-
-    template<typename T, typename U>
-    std::future<int> async(std::string fname, const rdmalib::Buffer<T> & in, rdmalib::Buffer<U> & out, int64_t size = -1)
+    // Has to be set before allocation.
+    void polling(polling_type type);
+    polling_statistics statistics() const;
+    // Called by the background thread.
+    void update_cpu_time();
+
+    template<typename T = char, typename U = char>
+    function_handle<T, U> function(const std::string & fname) const
     {
-      auto it = std::find(_func_names.begin(), _func_names.end(), fname);
-      if(it == _func_names.end()) {
+      // Function names are sorted when loading the library.
+      auto it = std::lower_bound(_func_names.begin(), _func_names.end(), fname);
+      if(it == _func_names.end() || *it != fname) {
         spdlog::error("Function {} not found in the deployed library!", fname);
-        return std::future<int>{};
+        return function_handle<T, U>{};
       }
-      int func_idx = std::distance(_func_names.begin(), it);
-
-      // FIXME: here get a future for async
-      char* data = static_cast<char*>(in.ptr());
-      // TODO: we assume here uintptr_t is 8 bytes
-      *reinterpret_cast<uint64_t*>(data) = out.address();
-      *reinterpret_cast<uint32_t*>(data + 8) = out.rkey();
-
-      int invoc_id = this->_invoc_id++;
-      //_futures[invoc_id] = std::move(std::promise<int>{});
-      _futures[invoc_id] = std::make_tuple(1, std::promise<int>{});
-      uint32_t submission_id = (invoc_id << 16) | (1 << 15) | func_idx;
+      return function_handle<T, U>{static_cast<int>(std::distance(_func_names.begin(), it))};
+    }
+
+    // Waits for a free completion slot when too many invocations are in flight.
+    int acquire_slot(int completions);
+    // Inputs have to contain at least the submission header.
+    bool valid_input(uint32_t bytes) const;
+    template<typename T>
+    bool valid_inputs(const std::vector<rdmalib::Buffer<T>> & in) const
+    {
+      return std::all_of(in.begin(), in.end(), [this](const rdmalib::Buffer<T> & buf) { return valid_input(buf.bytes()); });
+    }
+    // Inputs exceeding the size of executor's buffer are switched to the pull mode.
+    // The caller must register such buffers with IBV_ACCESS_REMOTE_READ.
+    pending_invocation invocation(const rdmalib::impl::Buffer & in, uint32_t bytes, uint32_t slot, bool solicited);
+    // Submit to the least loaded executor thread, or queue locally when the input rings of all threads are full.
+    void dispatch(pending_invocation && invocation);
+    // Invocations sent to the same executor thread are posted with a single doorbell.
+    void dispatch(std::vector<pending_invocation> && invocations);
+    // Returns number of processed completions.
+    int poll_completions(bool blocking);
+    // Functions below require holding the dispatch mutex.
+    // Returns completion slot, return value, and true if the invocation has finished.
+    // Finished invocations have to be passed to completion_table::resume after releasing the mutex.
+    std::tuple<int, int, bool> process_completion(const ibv_wc & wc);
+    int select_connection();
+    rdmalib::WriteRequest write_request(int conn_idx, pending_invocation && invocation);
+    // The send completion queue is shared - completions are returned to their connections.
+    int poll_send_completions(bool blocking);
+    void submit(int conn_idx, pending_invocation && invocation);
+
+    // Writes the submission header in front of input data, returns the invocation id.
+    // Shared slots complete several invocations, and they don't report the length of outputs.
+    template<typename T, typename U>
+    uint64_t write_header(const rdmalib::Buffer<T> & in, const rdmalib::Buffer<U> & out, int func_idx, bool solicited, bool shared_slot = false)
+    {
+      auto header = static_cast<rdmalib::functions::Submission*>(in.ptr());
+      header->r_address = out.address();
+      header->r_key = out.rkey();
+      header->func_id = func_idx;
+      header->invocation_id = _invoc_id++;
+      header->flags = solicited ? rdmalib::functions::Submission::SOLICITED : 0;
+      if(shared_slot)
+        header->flags |= rdmalib::functions::Submission::SHARED_SLOT;
+      header->r_size = out.bytes();
+      return header->invocation_id;
+    }
+
+    template<typename T, typename U>
+    rfaas::future async(const std::string & fname, const rdmalib::Buffer<T> & in, rdmalib::Buffer<U> & out, int64_t size = -1)
+    {
+      return async(function<T, U>(fname), in, out, size);
+    }
+
+    template<typename T, typename U>
+    rfaas::future async(function_handle<T, U> func, const rdmalib::Buffer<T> & in, rdmalib::Buffer<U> & out, int64_t size = -1)
+    {
+      uint32_t bytes = size != -1 ? size : in.bytes();
+      if(!func.valid() || !valid_input(bytes))
+        return rfaas::future{};
+      int func_idx = func.index;
+
+      [[maybe_unused]] uint64_t invoc_id = write_header(in, out, func_idx, true);
+      int slot = acquire_slot(1);
+      rfaas::future result{_completions.slot(slot)};
       SPDLOG_DEBUG(
-        "Invoke function {} with invocation id {}, submission id {}",
-        func_idx, invoc_id, submission_id
+        "Invoke function {} with invocation id {}, completion slot {}",
+        func_idx, invoc_id, slot
       );
-      if(size != -1) {
-        rdmalib::ScatterGatherElement sge;
-        sge.add(in, size, 0);
-        _connections[0].conn->post_write(
-          std::move(sge),
-          _connections[0].remote_input,
-          submission_id,
-          size <= _device.max_inline_data,
-          true
-        );
-      } else {
-        _connections[0].conn->post_write(
-          in,
-          _connections[0].remote_input,
-          submission_id,
-          in.bytes() <= _device.max_inline_data,
-          true
-        );
-      }
-      //_connections[0]._rcv_buffer.refill();
-      _connections[0].conn->receive_wcs().refill();
-      return std::get<1>(_futures[invoc_id]).get_future();
+      dispatch(invocation(in, bytes, slot, true));
+      return result;
+    }
+
+    // Coroutine-friendly invocation: `co_await executor.invoke(func, in, out)`.
+    // The coroutine is resumed by the thread polling the completion - the background thread,
+    // or the user calling poll_completions. No allocation is needed beyond the coroutine frame.
+    template<typename T, typename U>
+    awaitable_result invoke(function_handle<T, U> func, const rdmalib::Buffer<T> & in, rdmalib::Buffer<U> & out)
+    {
+      return awaitable_result{async(func, in, out)};
+    }
+
+    template<typename T, typename U>
+    awaitable_result invoke(const std::string & fname, const rdmalib::Buffer<T> & in, rdmalib::Buffer<U> & out)
+    {
+      return invoke(function<T, U>(fname), in, out);
     }
 
     template<typename T,typename U>
-    std::future<int> async(std::string fname, const std::vector<rdmalib::Buffer<T>> & in, std::vector<rdmalib::Buffer<U>> & out)
+    rfaas::future async(const std::string & fname, const std::vector<rdmalib::Buffer<T>> & in, std::vector<rdmalib::Buffer<U>> & out)
     {
-      auto it = std::find(_func_names.begin(), _func_names.end(), fname);
-      if(it == _func_names.end()) {
-        spdlog::error("Function {} not found in the deployed library!", fname);
-        return std::future<int>{};
+      return async(function<T, U>(fname), in, out);
+    }
+
+    template<typename T,typename U>
+    rfaas::future async(function_handle<T, U> func, const std::vector<rdmalib::Buffer<T>> & in, std::vector<rdmalib::Buffer<U>> & out)
+    {
+      if(!func.valid() || !valid_inputs(in))
+        return rfaas::future{};
+      int func_idx = func.index;
+
+      int invocations = in.size();
+      int slot = acquire_slot(invocations);
+      rfaas::future result{_completions.slot(slot)};
+      for(int i = 0; i < invocations; ++i) {
+        [[maybe_unused]] uint64_t invoc_id = write_header(in[i], out[i], func_idx, true, true);
+        SPDLOG_DEBUG("Invoke function {} with invocation id {}, completion slot {}", func_idx, invoc_id, slot);
+        dispatch(invocation(in[i], in[i].bytes(), slot, true));
       }
-      int func_idx = std::distance(_func_names.begin(), it);
-
-      int invoc_id = this->_invoc_id++;
-      //_futures[invoc_id] = std::move(std::promise<int>{});
-      int numcores = _connections.size();
-      _futures[invoc_id] = std::make_tuple(numcores, std::promise<int>{});
-      uint32_t submission_id = (invoc_id << 16) | (1 << 15) | func_idx;
-      for(int i = 0; i < numcores; ++i) {
-        // FIXME: here get a future for async
-        char* data = static_cast<char*>(in[i].ptr());
-        // TODO: we assume here uintptr_t is 8 bytes
-        *reinterpret_cast<uint64_t*>(data) = out[i].address();
-        *reinterpret_cast<uint32_t*>(data + 8) = out[i].rkey();
-
-        SPDLOG_DEBUG("Invoke function {} with invocation id {}", func_idx, _invoc_id);
-        _connections[i].conn->post_write(
-          in[i],
-          _connections[i].remote_input,
-          submission_id,
-          in[i].bytes() <= _device.max_inline_data,
-          true
+      return result;
+    }
+
+    template<typename T, typename U>
+    std::vector<rfaas::future> async_batch(const std::string & fname, const std::vector<rdmalib::Buffer<T>> & in, std::vector<rdmalib::Buffer<U>> & out)
+    {
+      return async_batch(function<T, U>(fname), in, out);
+    }
+
+    // Independent invocations, one for each pair of buffers.
+    // Returns no futures when the batch is larger than the completion table.
+    template<typename T, typename U>
+    std::vector<rfaas::future> async_batch(function_handle<T, U> func, const std::vector<rdmalib::Buffer<T>> & in, std::vector<rdmalib::Buffer<U>> & out)
+    {
+      return submit_batch(func, in, out, true);
+    }
+
+    template<typename T, typename U>
+    std::vector<rfaas::future> submit_batch(function_handle<T, U> func, const std::vector<rdmalib::Buffer<T>> & in, std::vector<rdmalib::Buffer<U>> & out, bool solicited)
+    {
+      std::vector<rfaas::future> results;
+      if(!func.valid() || !valid_inputs(in))
+        return results;
+
+      int invocations = in.size();
+      // Futures of the batch hold their slots until they're claimed - a larger batch could never finish.
+      if(invocations > _completions.capacity()) {
+        spdlog::error(
+          "Batch of {} invocations exceeds the capacity {} of the completion table",
+          invocations, _completions.capacity()
         );
+        return results;
       }
-
-      for(int i = 0; i < numcores; ++i) {
-        //_connections[i]._rcv_buffer.refill();
-        _connections[i].conn->receive_wcs().refill();
+      std::vector<pending_invocation> batch;
+      results.reserve(invocations);
+      batch.reserve(invocations);
+      for(int i = 0; i < invocations; ++i) {
+        [[maybe_unused]] uint64_t invoc_id = write_header(in[i], out[i], func.index, solicited);
+        int slot = _completions.acquire(1);
+        if(slot == -1) {
+          // Slots might be freed only by invocations that are not submitted yet.
+          dispatch(std::move(batch));
+          batch.clear();
+          slot = acquire_slot(1);
+        }
+        results.emplace_back(_completions.slot(slot));
+        SPDLOG_DEBUG("Invoke function {} with invocation id {}, completion slot {}", func.index, invoc_id, slot);
+        batch.push_back(invocation(in[i], in[i].bytes(), slot, solicited));
       }
-      return std::get<1>(_futures[invoc_id]).get_future();
+      dispatch(std::move(batch));
+      return results;
     }
 
     bool block()
     {
-      _connections[0].conn->poll_wc(rdmalib::QueueType::SEND, true);
-
-      //auto wc = _connections[0]._rcv_buffer.poll(true);
-      auto wc = _connections[0].conn->receive_wcs().poll(true);
-      uint32_t val = ntohl(std::get<0>(wc)[0].imm_data);
-      int return_val = val & 0x0000FFFF;
-      int finished_invoc_id = val >> 16;
+      int return_val = 0;
+      int slot = 0;
+      bool finished = false;
+      int processed = 0;
+      while(!processed) {
+        std::lock_guard<std::mutex> lock{_dispatch_mutex};
+        auto wc = _poller.poll(false, 1);
+        processed = std::get<1>(wc);
+        for(int i = 0; i < processed; ++i)
+          std::tie(slot, return_val, finished) = process_completion(std::get<0>(wc)[i]);
+      }
+      if(finished)
+        _completions.resume(slot);
       if(return_val == 0) {
-        SPDLOG_DEBUG("Finished invocation {} succesfully", finished_invoc_id);
+        SPDLOG_DEBUG("Finished invocation in slot {} succesfully", slot);
         return true;
       } else {
-        if(val == 1)
-          spdlog::error("Invocation: {}, Thread busy, cannot post work", finished_invoc_id);
+        if(return_val == 1)
+          spdlog::error("Invocation in slot {}, Thread busy, cannot post work", slot);
         else
-          spdlog::error("Invocation: {}, Unknown error {}", finished_invoc_id, val);
+          spdlog::error("Invocation in slot {}, Unknown error {}", slot, return_val);
         return false;
       }
     }
@@ -201,89 +402,44 @@ namespace rfaas {
     //template<class... Args>
     //void execute(int numcores, std::string fname, Args &&... args)
     template<typename T, typename U>
-    std::tuple<bool, int> execute(std::string fname, const rdmalib::Buffer<T> & in, rdmalib::Buffer<U> & out)
+    std::tuple<bool, int> execute(const std::string & fname, const rdmalib::Buffer<T> & in, rdmalib::Buffer<U> & out)
     {
-      auto it = std::find(_func_names.begin(), _func_names.end(), fname);
-      if(it == _func_names.end()) {
-        spdlog::error("Function {} not found in the deployed library!", fname);
-        return std::make_tuple(false, 0);
-      }
-      int func_idx = std::distance(_func_names.begin(), it);
+      return execute(function<T, U>(fname), in, out);
+    }
 
-      // FIXME: here get a future for async
-      char* data = static_cast<char*>(in.ptr());
-      // TODO: we assume here uintptr_t is 8 bytes
-      *reinterpret_cast<uint64_t*>(data) = out.address();
-      *reinterpret_cast<uint32_t*>(data + 8) = out.rkey();
+    template<typename T, typename U>
+    std::tuple<bool, int> execute(function_handle<T, U> func, const rdmalib::Buffer<T> & in, rdmalib::Buffer<U> & out)
+    {
+      if(!func.valid() || !valid_input(in.bytes()))
+        return std::make_tuple(false, 0);
+      int func_idx = func.index;
 
-      int invoc_id = this->_invoc_id++;
+      uint64_t invoc_id = write_header(in, out, func_idx, false);
+      int slot = acquire_slot(1);
+      rfaas::future result{_completions.slot(slot)};
       SPDLOG_DEBUG(
-        "Invoke function {} with invocation id {}, submission id {}",
-        func_idx, invoc_id, (invoc_id << 16) | func_idx
-      );
-      _connections[0].conn->post_write(
-        in,
-        _connections[0].remote_input,
-        (invoc_id << 16) | func_idx,
-        in.bytes() <= _device.max_inline_data
+        "Invoke function {} with invocation id {}, completion slot {}",
+        func_idx, invoc_id, slot
       );
       _active_polling = true;
-      //_connections[0]._rcv_buffer.refill();
-      _connections[0].conn->receive_wcs().refill();
-
-      bool found_result = false;
-      int return_value = 0;
-      int out_size = 0;
-      while(!found_result) {
-        //auto wc = _connections[0]._rcv_buffer.poll(true);
-        auto wc = _connections[0].conn->receive_wcs().poll(true);
-        for(int i = 0; i < std::get<1>(wc); ++i) {
-          uint32_t val = ntohl(std::get<0>(wc)[i].imm_data);
-          int return_val = val & 0x0000FFFF;
-          int finished_invoc_id = val >> 16;
-
-          if(finished_invoc_id == invoc_id) {
-            found_result = true;
-            return_value = return_val;
-            out_size = std::get<0>(wc)[i].byte_len;
-            //spdlog::info("Result for id {}", finished_invoc_id);
-          } else {
-            auto it = _futures.find(finished_invoc_id);
-            //spdlog::info("Poll Future for id {}", finished_invoc_id);
-            // if it == end -> we have a bug, should never appear
-            //(*it).second.set_value(return_val);
-            if(!--std::get<0>(it->second))
-              std::get<1>(it->second).set_value(return_val);
-          }
-        }
-        if(found_result) {
-          _active_polling = false;
-          //auto wc = _connections[0]._rcv_buffer.poll(false);
-          auto wc = _connections[0].conn->receive_wcs().poll(false);
-          // Catch very unlikely interleaving
-          // Event arrives after we poll while the background thread is skipping
-          // because we still hold the atomic
-          // Thus, we later unset the variable since we're done
-          for(int i = 0; i < std::get<1>(wc); ++i) {
-            uint32_t val = ntohl(std::get<0>(wc)[i].imm_data);
-            int return_val = val & 0x0000FFFF;
-            int finished_invoc_id = val >> 16;
-            auto it = _futures.find(finished_invoc_id);
-            //spdlog::info("Poll Future for id {}", finished_invoc_id);
-            // if it == end -> we have a bug, should never appear
-            //(*it).second.set_value(return_val);
-            if(!--std::get<0>(it->second))
-              std::get<1>(it->second).set_value(return_val);
-          }
-        }
-      }
-      _connections[0].conn->poll_wc(rdmalib::QueueType::SEND, false);
+      dispatch(invocation(in, in.bytes(), slot, false));
+
+      // The result might be processed by the background thread
+      // when it's woken up by a completion of an asynchronous invocation.
+      while(!result.is_ready())
+        poll_completions(false);
+      _active_polling = false;
+
+      uint32_t out_size = result.bytes();
+      int return_value = result.get();
       if(return_value == 0) {
         SPDLOG_DEBUG("Finished invocation {} succesfully", invoc_id);
         return std::make_tuple(true, out_size);
       } else {
         if(return_value == 1)
           spdlog::error("Invocation: {}, Thread busy, cannot post work", invoc_id);
+        else if(return_value == rdmalib::functions::Submission::OUTPUT_TOO_LARGE)
+          spdlog::error("Invocation: {}, output of {} bytes does not fit into the buffer of {} bytes", invoc_id, out_size, out.bytes());
         else
           spdlog::error("Invocation: {}, Unknown error {}", invoc_id, return_value);
         return std::make_tuple(false, 0);
@@ -291,72 +447,69 @@ namespace rfaas {
     }
 
     template<typename T>
-    bool execute(std::string fname, const std::vector<rdmalib::Buffer<T>> & in, std::vector<rdmalib::Buffer<T>> & out)
+    bool execute(const std::string & fname, const std::vector<rdmalib::Buffer<T>> & in, std::vector<rdmalib::Buffer<T>> & out)
     {
-      auto it = std::find(_func_names.begin(), _func_names.end(), fname);
-      if(it == _func_names.end()) {
-        spdlog::error("Function {} not found in the deployed library!", fname);
+      return execute(function<T, T>(fname), in, out);
+    }
+
+    template<typename T>
+    bool execute(function_handle<T, T> func, const std::vector<rdmalib::Buffer<T>> & in, std::vector<rdmalib::Buffer<T>> & out)
+    {
+      if(!func.valid() || !valid_inputs(in))
         return false;
-      }
-      int func_idx = std::distance(_func_names.begin(), it);
-
-      int numcores = _connections.size();
-      for(int i = 0; i < numcores; ++i) {
-        // FIXME: here get a future for async
-        char* data = static_cast<char*>(in[i].ptr());
-        // TODO: we assume here uintptr_t is 8 bytes
-        *reinterpret_cast<uint64_t*>(data) = out[i].address();
-        *reinterpret_cast<uint32_t*>(data + 8) = out[i].rkey();
-
-        SPDLOG_DEBUG("Invoke function {} with invocation id {}", func_idx, _invoc_id);
-        _connections[i].conn->post_write(
-          in[i],
-          _connections[i].remote_input,
-          (_invoc_id++ << 16) | func_idx,
-          in[i].bytes() <= _device.max_inline_data
-        );
-      }
+      int func_idx = func.index;
 
-      for(int i = 0; i < numcores; ++i) {
-        //_connections[i]._rcv_buffer.refill();
-        _connections[i].conn->receive_wcs().refill();
+      int invocations = in.size();
+      int slot = acquire_slot(invocations);
+      rfaas::future result{_completions.slot(slot)};
+      _active_polling = true;
+      for(int i = 0; i < invocations; ++i) {
+        [[maybe_unused]] uint64_t invoc_id = write_header(in[i], out[i], func_idx, false, true);
+        SPDLOG_DEBUG("Invoke function {} with invocation id {}, completion slot {}", func_idx, invoc_id, slot);
+        dispatch(invocation(in[i], in[i].bytes(), slot, false));
       }
-      int expected = numcores;
-      while(expected) {
-        auto wc = _connections[0].conn->poll_wc(rdmalib::QueueType::SEND, true);
-        expected -= std::get<1>(wc);
+
+      while(!result.is_ready())
+        poll_completions(false);
+      _active_polling = false;
+
+      int return_value = result.get();
+      if(return_value == 0) {
+        SPDLOG_DEBUG("Finished invocations in slot {} succesfully", slot);
+      } else {
+        if(return_value == 1)
+          spdlog::error("Invocations in slot {}, Thread busy, cannot post work", slot);
+        else
+          spdlog::error("Invocations in slot {}, Unknown error {}", slot, return_value);
       }
+      return return_value == 0;
+    }
+
+    template<typename T, typename U>
+    bool execute_batch(const std::string & fname, const std::vector<rdmalib::Buffer<T>> & in, std::vector<rdmalib::Buffer<U>> & out)
+    {
+      return execute_batch(function<T, U>(fname), in, out);
+    }
+
+    template<typename T, typename U>
+    bool execute_batch(function_handle<T, U> func, const std::vector<rdmalib::Buffer<T>> & in, std::vector<rdmalib::Buffer<U>> & out)
+    {
+      if(!func.valid())
+        return false;
 
-      expected = numcores;
-      bool correct = true;
       _active_polling = true;
-      while(expected) {
-        //auto wc = _connections[0]._rcv_buffer.poll(true);
-        auto wc = _connections[0].conn->receive_wcs().poll(true);
-        expected -= std::get<1>(wc);
-        for(int i = 0; i < std::get<1>(wc); ++i) {
-          uint32_t val = ntohl(std::get<0>(wc)[i].imm_data);
-          int return_val = val & 0x0000FFFF;
-          int finished_invoc_id = val >> 16;
-          if(return_val == 0) {
-            SPDLOG_DEBUG("Finished invocation {} succesfully", finished_invoc_id);
-          } else {
-            if(val == 1)
-              spdlog::error("Invocation: {}, Thread busy, cannot post work", finished_invoc_id);
-            else
-              spdlog::error("Invocation: {}, Unknown error {}", finished_invoc_id, val);
-          }
-          correct &= return_val == 0;
-        }
+      auto results = submit_batch(func, in, out, false);
+      if(results.size() != in.size()) {
+        _active_polling = false;
+        return false;
+      }
+      bool correct = true;
+      for(auto & result : results) {
+        while(!result.is_ready())
+          poll_completions(false);
+        correct &= result.get() == 0;
       }
       _active_polling = false;
-
-      // We polled from connection number 0, time to update.
-      //_connections[0]._rcv_buffer._requests += numcores - 1;
-      _connections[0].conn->receive_wcs().update_requests(numcores - 1);
-      for(int i = 1; i < numcores; ++i)
-        //_connections[i]._rcv_buffer._requests--;
-        _connections[0].conn->receive_wcs().update_requests(-1);
       return correct;
     }
   };
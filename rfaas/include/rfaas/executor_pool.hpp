@@ -0,0 +1,109 @@
+
+#ifndef __RFAAS_EXECUTOR_POOL_HPP__
+#define __RFAAS_EXECUTOR_POOL_HPP__
+
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <rfaas/client.hpp>
+#include <rfaas/devices.hpp>
+#include <rfaas/executor.hpp>
+
+namespace rfaas {
+
+  struct executor_pool;
+
+  // Executor borrowed from the pool, returned to it on destruction.
+  struct pooled_executor {
+
+    pooled_executor();
+    pooled_executor(executor_pool* pool, const std::string & library, std::unique_ptr<executor> && exec);
+    ~pooled_executor();
+
+    pooled_executor(const pooled_executor &) = delete;
+    pooled_executor& operator=(const pooled_executor &) = delete;
+    pooled_executor(pooled_executor && obj);
+    pooled_executor& operator=(pooled_executor && obj);
+
+    executor* operator->() const;
+    executor& operator*() const;
+    explicit operator bool() const;
+
+    // Returns the executor to the pool.
+    void release();
+
+  private:
+    executor_pool* _pool;
+    std::string _library;
+    std::unique_ptr<executor> _exec;
+  };
+
+  // Keeps allocated executors for each function library, avoiding the cold start
+  // of leasing, spawning and connecting executor processes for each job.
+  // Executors idle longer than the idle timeout are deallocated and their leases returned.
+  // Eviction is done when the pool is used, or explicitly with `evict`.
+  struct executor_pool {
+    // Provides executors that have not been allocated yet.
+    typedef std::function<std::unique_ptr<executor>()> lease_t;
+    static constexpr std::chrono::milliseconds DEFAULT_IDLE_TIMEOUT{60000};
+
+    // Hot timeout is passed to executors, in microseconds.
+    // Zero idle timeout keeps idle executors until they're replaced by more recently used ones.
+    executor_pool(lease_t lease, int warm_executors, int max_input_size,
+        int hot_timeout, bool skip_resource_manager = false,
+        std::chrono::milliseconds idle_timeout = DEFAULT_IDLE_TIMEOUT);
+    ~executor_pool();
+
+    executor_pool(const executor_pool &) = delete;
+    executor_pool& operator=(const executor_pool &) = delete;
+
+    // Leases from the resource manager.
+    static lease_t leases(client & instance, int16_t cores, int32_t memory, device_data & dev);
+
+    // Returns the most recently used executor, or allocates a new one when none is idle.
+    // The returned object is empty when the allocation fails.
+    pooled_executor acquire(const std::string & library);
+    // Allocates executors concurrently until the library has the configured number of idle executors.
+    int prewarm(const std::string & library);
+    // Executors above the configured number of idle executors are deallocated.
+    void release(const std::string & library, std::unique_ptr<executor> && exec);
+    // Returns the number of deallocated executors.
+    int evict();
+    size_t idle(const std::string & library);
+
+  private:
+    typedef std::chrono::steady_clock clock_t;
+
+    struct idle_executor {
+      std::unique_ptr<executor> exec;
+      clock_t::time_point since;
+    };
+
+    lease_t _lease;
+    int _warm_executors;
+    int _max_input_size;
+    int _hot_timeout;
+    bool _skip_resource_manager;
+    std::chrono::milliseconds _idle_timeout;
+    std::mutex _mutex;
+    // Connection to the resource manager is not thread-safe.
+    std::mutex _lease_mutex;
+    // Idle executors for each library, the most recently used at the back.
+    std::unordered_map<std::string, std::deque<idle_executor>> _idle;
+
+    std::unique_ptr<executor> lease();
+    std::unique_ptr<executor> allocate(const std::string & library);
+    // Called with the lock held, the evicted executors are deallocated after unlocking.
+    void expired(std::vector<std::unique_ptr<executor>> & evicted);
+  };
+
+}
+
+#endif
+
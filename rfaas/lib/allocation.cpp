@@ -0,0 +1,21 @@
+
+#include <openssl/evp.h>
+
+#include <rdmalib/util.hpp>
+
+#include <rfaas/allocation.hpp>
+
+namespace rfaas {
+
+  LibraryDigest library_digest(const void* data, size_t size)
+  {
+    LibraryDigest digest;
+    unsigned int length = 0;
+    rdmalib::impl::expect_true(
+      EVP_Digest(data, size, digest.data(), &length, EVP_sha256(), nullptr) == 1 &&
+      length == digest.size()
+    );
+    return digest;
+  }
+
+}
@@ -0,0 +1,153 @@
+
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+
+#include <sys/mman.h>
+
+#include <spdlog/spdlog.h>
+
+#include <rdmalib/util.hpp>
+
+#include <rfaas/buffer_pool.hpp>
+
+namespace rfaas {
+
+  typedef std::array<std::vector<pool_block>, buffer_pool::NUM_CLASSES> class_caches;
+
+  // Caches of the calling thread, one for each pool it used.
+  // The last used pool is remembered to avoid the lookup on the fast path.
+  struct thread_caches {
+    uint64_t last_pool = 0;
+    class_caches* last = nullptr;
+    std::unordered_map<uint64_t, class_caches> caches;
+  };
+
+  static thread_local thread_caches local_caches;
+  static std::atomic<uint64_t> pool_counter{1};
+
+  buffer_pool::buffer_pool(ibv_pd* pd, int access, rdmalib::NumaPolicy policy):
+    _pd(pd),
+    _access(access),
+    _numa_policy(policy),
+    _id(pool_counter.fetch_add(1)),
+    _registered(0)
+  {}
+
+  buffer_pool::~buffer_pool()
+  {
+    // Caches of other threads are never accessed again since pool IDs are not reused.
+    if(local_caches.last_pool == _id) {
+      local_caches.last_pool = 0;
+      local_caches.last = nullptr;
+    }
+    local_caches.caches.erase(_id);
+  }
+
+  int buffer_pool::class_of(size_t bytes)
+  {
+    int shift = MIN_CLASS_SHIFT;
+    while((static_cast<size_t>(1) << shift) < bytes)
+      ++shift;
+    return shift > MAX_CLASS_SHIFT ? -1 : shift - MIN_CLASS_SHIFT;
+  }
+
+  std::vector<pool_block>& buffer_pool::thread_cache(int size_class)
+  {
+    if(local_caches.last_pool != _id) {
+      local_caches.last = &local_caches.caches[_id];
+      local_caches.last_pool = _id;
+    }
+    return (*local_caches.last)[size_class];
+  }
+
+  pool_block buffer_pool::acquire_block(int size_class, size_t bytes)
+  {
+    // Too large for arenas - register the memory separately.
+    if(size_class == -1) {
+      void* ptr = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      rdmalib::impl::expect_true(ptr != MAP_FAILED);
+      rdmalib::impl::apply_numa_policy(ptr, bytes, _numa_policy, _pd->context);
+      ibv_mr* mr = ibv_reg_mr(_pd, ptr, bytes, _access);
+      rdmalib::impl::expect_nonnull(mr);
+      SPDLOG_DEBUG("Registered separate buffer of {} bytes, address {}", bytes, fmt::ptr(ptr));
+      return pool_block{ptr, mr};
+    }
+
+    std::vector<pool_block> & cache = thread_cache(size_class);
+    if(cache.empty())
+      refill(size_class, cache);
+    pool_block block = cache.back();
+    cache.pop_back();
+    return block;
+  }
+
+  void buffer_pool::release(int size_class, pool_block block)
+  {
+    if(size_class == -1) {
+      size_t bytes = block.mr->length;
+      ibv_dereg_mr(block.mr);
+      munmap(block.ptr, bytes);
+      return;
+    }
+
+    std::vector<pool_block> & cache = thread_cache(size_class);
+    cache.push_back(block);
+    if(cache.size() > THREAD_CACHE_SIZE)
+      flush(size_class, cache);
+  }
+
+  void buffer_pool::refill(int size_class, std::vector<pool_block> & cache)
+  {
+    free_list & cls = _classes[size_class];
+    std::lock_guard<std::mutex> lock{cls.lock};
+    if(cls.free.empty())
+      allocate_arena(size_class);
+    size_t count = std::min(cls.free.size(), THREAD_CACHE_SIZE / 2);
+    cache.insert(cache.end(), cls.free.end() - count, cls.free.end());
+    cls.free.resize(cls.free.size() - count);
+  }
+
+  void buffer_pool::flush(int size_class, std::vector<pool_block> & cache)
+  {
+    free_list & cls = _classes[size_class];
+    std::lock_guard<std::mutex> lock{cls.lock};
+    size_t count = cache.size() / 2;
+    cls.free.insert(cls.free.end(), cache.end() - count, cache.end());
+    cache.resize(cache.size() - count);
+  }
+
+  void buffer_pool::allocate_arena(int size_class)
+  {
+    size_t block_size = static_cast<size_t>(1) << (size_class + MIN_CLASS_SHIFT);
+    size_t blocks = ARENA_SIZE / block_size;
+
+    char* ptr = nullptr;
+    ibv_mr* mr = nullptr;
+    {
+      std::lock_guard<std::mutex> lock{_arenas_lock};
+      _arenas.emplace_back(ARENA_SIZE, 0, _numa_policy);
+      _arenas.back().register_memory(_pd, _access);
+      ptr = _arenas.back().data();
+      mr = _arenas.back().mr();
+      _registered += ARENA_SIZE;
+    }
+    SPDLOG_DEBUG(
+      "Registered arena of {} bytes for blocks of size {}, total registered {}",
+      ARENA_SIZE, block_size, registered()
+    );
+
+    std::vector<pool_block> & free = _classes[size_class].free;
+    free.reserve(free.size() + blocks);
+    for(size_t i = 0; i < blocks; ++i)
+      free.push_back(pool_block{ptr + i * block_size, mr});
+  }
+
+  size_t buffer_pool::registered() const
+  {
+    std::lock_guard<std::mutex> lock{_arenas_lock};
+    return _registered;
+  }
+
+}
+
@@ -0,0 +1,240 @@
+
+#include <climits>
+#include <stdexcept>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include <rdmalib/functions.hpp>
+
+#include <rfaas/completions.hpp>
+
+namespace rfaas {
+
+  static_assert(
+    !(completion_table::DEFAULT_CAPACITY & (completion_table::DEFAULT_CAPACITY - 1)) &&
+    completion_table::DEFAULT_CAPACITY <= rdmalib::functions::Submission::SLOT_MASK,
+    "Default capacity of completion table must be a power of two that fits into the slot mask"
+  );
+
+  // Number of checks before the waiting thread is parked.
+  static constexpr int SPIN_ITERATIONS = 1 << 14;
+
+  // States of slot's continuation.
+  static constexpr int CONTINUATION_NONE = 0;
+  static constexpr int CONTINUATION_REGISTERED = 1;
+  static constexpr int CONTINUATION_TAKEN = 2;
+
+  static void futex_wait(std::atomic<int> * addr, int expected)
+  {
+    syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+  }
+
+  static void futex_wake(std::atomic<int> * addr)
+  {
+    syscall(SYS_futex, reinterpret_cast<int*>(addr), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+  }
+
+  future::future(completion_slot* slot):
+    _slot(slot)
+  {}
+
+  future::~future()
+  {
+    release();
+  }
+
+  future::future(future && obj):
+    _slot(obj._slot)
+  {
+    obj._slot = nullptr;
+  }
+
+  future& future::operator=(future && obj)
+  {
+    if(this != &obj) {
+      release();
+      _slot = obj._slot;
+      obj._slot = nullptr;
+    }
+    return *this;
+  }
+
+  void future::release()
+  {
+    if(_slot) {
+      _slot->references.fetch_sub(1);
+      _slot = nullptr;
+    }
+  }
+
+  bool future::valid() const
+  {
+    return _slot;
+  }
+
+  bool future::is_ready() const
+  {
+    return _slot && !_slot->remaining.load(std::memory_order_acquire);
+  }
+
+  void future::wait() const
+  {
+    if(!_slot)
+      return;
+
+    for(int i = 0; i < SPIN_ITERATIONS; ++i) {
+      if(!_slot->remaining.load(std::memory_order_acquire))
+        return;
+    }
+
+    _slot->waiters.fetch_add(1);
+    int remaining;
+    while((remaining = _slot->remaining.load()) != 0)
+      futex_wait(&_slot->remaining, remaining);
+    _slot->waiters.fetch_sub(1);
+  }
+
+  int future::get()
+  {
+    if(!_slot) {
+      spdlog::error("Waiting on a future without an associated invocation!");
+      return -1;
+    }
+    wait();
+    int result = _slot->result.load();
+    release();
+    return result;
+  }
+
+  bool future::on_completion(void (*callback)(void*), void* data)
+  {
+    if(!_slot)
+      return false;
+
+    _slot->continuation = callback;
+    _slot->continuation_data = data;
+    _slot->continuation_state.store(CONTINUATION_REGISTERED);
+    // The poller could have missed the registration - take back the continuation.
+    // Otherwise, the poller has already taken it and will call it.
+    if(!_slot->remaining.load())
+      return _slot->continuation_state.exchange(CONTINUATION_TAKEN) != CONTINUATION_REGISTERED;
+    return true;
+  }
+
+  uint32_t future::bytes() const
+  {
+    return _slot ? _slot->bytes.load() : 0;
+  }
+
+  // Slot index is used as a mask, and it has to fit into the immediate value.
+  // Otherwise, slots would alias and results would be delivered to wrong invocations.
+  // Verified before the slots are allocated.
+  static int valid_capacity(int capacity)
+  {
+    if(capacity <= 0 || capacity & (capacity - 1) ||
+        static_cast<uint32_t>(capacity) > rdmalib::functions::Submission::SLOT_MASK) {
+      spdlog::error("Capacity of completion table {} must be a power of two smaller than 2^24", capacity);
+      throw std::invalid_argument("Invalid capacity of completion table");
+    }
+    return capacity;
+  }
+
+  completion_table::completion_table(int capacity):
+    _capacity(valid_capacity(capacity)),
+    _head(0),
+    _slots(new completion_slot[_capacity])
+  {
+    for(int i = 0; i < _capacity; ++i) {
+      _slots[i].references = 0;
+      _slots[i].remaining = 0;
+      _slots[i].waiters = 0;
+      _slots[i].result = 0;
+      _slots[i].bytes = 0;
+      _slots[i].continuation_state = CONTINUATION_NONE;
+      _slots[i].continuation = nullptr;
+      _slots[i].continuation_data = nullptr;
+    }
+  }
+
+  completion_table::completion_table(completion_table && obj):
+    _capacity(obj._capacity),
+    _head(obj._head.load()),
+    _slots(std::move(obj._slots))
+  {
+    obj._capacity = 0;
+  }
+
+  completion_table& completion_table::operator=(completion_table && obj)
+  {
+    _capacity = obj._capacity;
+    _head = obj._head.load();
+    _slots = std::move(obj._slots);
+    obj._capacity = 0;
+    return *this;
+  }
+
+  int completion_table::acquire(int completions)
+  {
+    uint32_t start = _head.fetch_add(1, std::memory_order_relaxed);
+    for(int i = 0; i < _capacity; ++i) {
+      int idx = (start + i) & (_capacity - 1);
+      int expected = 0;
+      // One reference for the invocation and one for its future.
+      if(_slots[idx].references.compare_exchange_strong(expected, 2)) {
+        _slots[idx].result.store(0, std::memory_order_relaxed);
+        _slots[idx].bytes.store(0, std::memory_order_relaxed);
+        _slots[idx].continuation_state.store(CONTINUATION_NONE, std::memory_order_relaxed);
+        _slots[idx].remaining.store(completions, std::memory_order_release);
+        return idx;
+      }
+    }
+    return -1;
+  }
+
+  bool completion_table::complete(int idx, int result, uint32_t bytes)
+  {
+    if(idx < 0 || idx >= _capacity || _slots[idx].remaining.load() <= 0) {
+      spdlog::error("Received completion for an inactive slot {}", idx);
+      return false;
+    }
+
+    completion_slot & slot = _slots[idx];
+    if(result) {
+      int expected = 0;
+      slot.result.compare_exchange_strong(expected, result);
+    }
+    slot.bytes.store(bytes, std::memory_order_relaxed);
+    if(slot.remaining.fetch_sub(1) == 1) {
+      if(slot.waiters.load())
+        futex_wake(&slot.remaining);
+      return true;
+    }
+    return false;
+  }
+
+  void completion_table::resume(int idx)
+  {
+    completion_slot & slot = _slots[idx];
+    if(slot.continuation_state.exchange(CONTINUATION_TAKEN) == CONTINUATION_REGISTERED)
+      slot.continuation(slot.continuation_data);
+    // The invocation no longer needs the slot.
+    // Released only now to prevent reuse of the slot before the continuation is handled.
+    slot.references.fetch_sub(1);
+  }
+
+  completion_slot* completion_table::slot(int idx) const
+  {
+    return &_slots[idx];
+  }
+
+  int completion_table::capacity() const
+  {
+    return _capacity;
+  }
+
+}
+
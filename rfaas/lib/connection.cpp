@@ -84,13 +84,22 @@ namespace rfaas {
   }
 
   bool manager_connection::submit()
+  {
+    send_request();
+    return receive_response();
+  }
+
+  void manager_connection::send_request()
   {
     rdmalib::ScatterGatherElement sge;
     size_t obj_size = sizeof(AllocationRequest);
     sge.add(_allocation_buffer, obj_size, sizeof(LeaseStatus)*_rcv_buf_size);
     _active.connection().post_send(sge);
     _active.connection().poll_wc(rdmalib::QueueType::SEND, true);
+  }
 
+  bool manager_connection::receive_response()
+  {
     auto response = poll_response();
     if(!response) {
       return false;
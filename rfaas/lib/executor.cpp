@@ -1,3 +1,4 @@
+#include <chrono>
 
 #include <spdlog/spdlog.h>
 
@@ -17,6 +18,7 @@
 #include <elf.h>
 #include <link.h>
 #include <poll.h>
+#include <time.h>
 
 namespace rfaas {
 
@@ -32,37 +34,108 @@ namespace rfaas {
     return _timeout;
   }
 
+  polling_counters::polling_counters():
+    hot_completions(0),
+    warm_completions(0),
+    wakeups(0),
+    spin_time(0),
+    cpu_time(0)
+  {}
+
+  polling_counters::polling_counters(const polling_counters & obj):
+    hot_completions(obj.hot_completions.load()),
+    warm_completions(obj.warm_completions.load()),
+    wakeups(obj.wakeups.load()),
+    spin_time(obj.spin_time.load()),
+    cpu_time(obj.cpu_time.load())
+  {}
+
+  polling_counters& polling_counters::operator=(const polling_counters & obj)
+  {
+    hot_completions = obj.hot_completions.load();
+    warm_completions = obj.warm_completions.load();
+    wakeups = obj.wakeups.load();
+    spin_time = obj.spin_time.load();
+    cpu_time = obj.cpu_time.load();
+    return *this;
+  }
+
+  polling_statistics polling_counters::load() const
+  {
+    return polling_statistics{
+      hot_completions.load(), warm_completions.load(),
+      wakeups.load(), spin_time.load(), cpu_time.load()
+    };
+  }
+
   executor_state::executor_state(rdmalib::Connection* conn, int rcv_buf_size):
-    conn(conn)
+    conn(conn),
+    input_slot_size(0),
+    input_slots(1),
+    input_tail(0),
+    outstanding(0),
+    max_outstanding(1)
+  {
+  }
+
+  static LeasedNode leased_node(const std::string& address, int port, int numcores, int lease_id)
   {
+    LeasedNode node{lease_id, port, static_cast<int16_t>(numcores), ""};
+    strncpy(node.address, address.c_str(), sizeof(node.address) - 1);
+    return node;
+  }
+
+  static int lease_cores(const std::vector<LeasedNode> & nodes)
+  {
+    int cores = 0;
+    for(auto & node : nodes)
+      cores += node.cores;
+    return cores;
   }
 
   executor::executor(const std::string& address, int port, int numcores, int memory, int lease_id, device_data & dev):
+    executor(std::vector<LeasedNode>{leased_node(address, port, numcores, lease_id)}, memory, dev)
+  {}
+
+  executor::executor(const std::vector<LeasedNode> & nodes, int memory, device_data & dev):
     _state(dev.ip_address, dev.port, dev.default_receive_buffer_size + 1),
-    _execs_buf(MAX_REMOTE_WORKERS),
+    // Buffers are indexed by executor threads - one per leased core.
+    _execs_buf(std::max(lease_cores(nodes), 1)),
     _device(dev),
-    _numcores(numcores),
+    _numcores(lease_cores(nodes)),
     _memory(memory),
     _executions(0),
+    _max_input_size(0),
     _invoc_id(0),
-    _lease_id(lease_id)
+    _nodes(nodes),
+    _polling(polling_type::WARM_ALWAYS),
+    _next_conn(0),
+    _descriptors(std::max(_numcores, 1) * MAX_INPUT_SLOTS),
+    _result_lengths(_completions.capacity()),
+    _result_lengths_info(1)
   {
     _execs_buf.register_memory(_state.pd(), IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
+    _descriptors.register_memory(_state.pd(), IBV_ACCESS_LOCAL_WRITE);
+    _result_lengths.register_memory(_state.pd(), IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
+    _result_lengths_info.register_memory(_state.pd(), IBV_ACCESS_LOCAL_WRITE);
+    _result_lengths_info.data()[0].r_addr = _result_lengths.address();
+    _result_lengths_info.data()[0].r_key = _result_lengths.rkey();
     events = 0;
     _active_polling = false;
     _end_requested = false;
 
+    for(auto & node : _nodes) {
+      _exec_managers.emplace_back(
+        new manager_connection(
+          node.address,
+          node.port,
+          dev.default_receive_buffer_size,
+          dev.max_inline_data
+        )
+      );
+    }
     // Enables sharing receive queue across all connections.
-    _state.register_shared_queue(0, true);
-
-    _exec_manager.reset(
-      new manager_connection(
-        address,
-        port,
-        dev.default_receive_buffer_size,
-        dev.max_inline_data
-      )
-    );
+    _state.register_shared_queue(0, true, std::max(_numcores, 1));
   }
 
   executor::~executor()
@@ -77,13 +150,23 @@ namespace rfaas {
     _numcores(std::move(obj._numcores)),
     _memory(std::move(obj._memory)),
     _executions(std::move(obj._executions)),
-    _invoc_id(std::move(obj._invoc_id)),
-    _lease_id(std::move(obj._lease_id)),
+    _max_input_size(std::move(obj._max_input_size)),
+    _invoc_id(obj._invoc_id.load()),
+    _nodes(std::move(obj._nodes)),
     _connections(std::move(obj._connections)),
-    _exec_manager(std::move(obj._exec_manager)),
+    _exec_managers(std::move(obj._exec_managers)),
     _func_names(std::move(obj._func_names)),
-    _futures(std::move(obj._futures)),
-    _background_thread(std::move(obj._background_thread))
+    _polling(obj._polling),
+    _polling_counters(obj._polling_counters),
+    _completions(std::move(obj._completions)),
+    _background_thread(std::move(obj._background_thread)),
+    _pending(std::move(obj._pending)),
+    _qp_to_conn(std::move(obj._qp_to_conn)),
+    _next_conn(std::move(obj._next_conn)),
+    _poller(std::move(obj._poller)),
+    _descriptors(std::move(obj._descriptors)),
+    _result_lengths(std::move(obj._result_lengths)),
+    _result_lengths_info(std::move(obj._result_lengths_info))
   {
     _end_requested = obj._end_requested.load();
     obj._end_requested.store(false);
@@ -103,13 +186,23 @@ namespace rfaas {
     _numcores = std::move(obj._numcores);
     _memory = std::move(obj._memory);
     _executions = std::move(obj._executions);
-    _invoc_id = std::move(obj._invoc_id);
-    _lease_id = std::move(obj._lease_id);
+    _max_input_size = std::move(obj._max_input_size);
+    _invoc_id = obj._invoc_id.load();
+    _nodes = std::move(obj._nodes);
     _connections = std::move(obj._connections);
-    _exec_manager = std::move(obj._exec_manager);
+    _exec_managers = std::move(obj._exec_managers);
     _func_names = std::move(obj._func_names);
-    _futures = std::move(obj._futures);
+    _polling = obj._polling;
+    _polling_counters = obj._polling_counters;
+    _completions = std::move(obj._completions);
     _background_thread = std::move(obj._background_thread);
+    _pending = std::move(obj._pending);
+    _qp_to_conn = std::move(obj._qp_to_conn);
+    _next_conn = std::move(obj._next_conn);
+    _poller = std::move(obj._poller);
+    _descriptors = std::move(obj._descriptors);
+    _result_lengths = std::move(obj._result_lengths);
+    _result_lengths_info = std::move(obj._result_lengths_info);
 
     _end_requested = obj._end_requested.load();
     obj._end_requested.store(false);
@@ -131,7 +224,8 @@ namespace rfaas {
     rewind(file);
     rdmalib::Buffer<char> functions(len);
     rdmalib::impl::expect_true(fread(functions.data(), 1, len, file) == len);
-    functions.register_memory(_state.pd(), IBV_ACCESS_LOCAL_WRITE);
+    // Executor manager reads the library when it's not cached.
+    functions.register_memory(_state.pd(), IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_READ);
     fclose(file);
 
     // FIXME: same function as in server/functions.cpp - merge?
@@ -177,6 +271,8 @@ namespace rfaas {
       }
     }
     std::sort(_func_names.begin(), _func_names.end());
+    // Function indices must match the executor, which doesn't list hooks either.
+    rdmalib::functions::remove_hooks(_func_names);
     dlclose(library_handle);
 
     return functions;
@@ -184,19 +280,23 @@ namespace rfaas {
 
   void executor::deallocate()
   {
-    if(_exec_manager) {
+    if(!_exec_managers.empty()) {
       _end_requested = true;
       // The background thread could be nullptr if we failed in the allocation process
       if(_background_thread) {
         _background_thread->join();
         _background_thread.reset();
       }
-      _exec_manager->disconnect();
-      _exec_manager.reset(nullptr);
+      for(auto & manager : _exec_managers)
+        manager->disconnect();
+      _exec_managers.clear();
       _state._cfg.attr.send_cq = _state._cfg.attr.recv_cq = 0;
 
       // Clear up old connections
       _connections.clear();
+      _qp_to_conn.clear();
+      _pending.clear();
+      _poller = rdmalib::Poller{};
     }
   }
 
@@ -212,7 +312,34 @@ namespace rfaas {
       return;
     }
 
+    std::chrono::microseconds spin_budget{std::max(0, static_cast<int>(_polling))};
+    bool hot_always = _polling == polling_type::HOT_ALWAYS;
     while(!_end_requested && _connections.size()) {
+
+      // Spin after each completion - the next one is likely to arrive soon.
+      auto start = std::chrono::steady_clock::now();
+      auto last_completion = start, now = start;
+      do {
+        int processed = poll_completions(false);
+        now = std::chrono::steady_clock::now();
+        if(processed > 0) {
+          _polling_counters.hot_completions += processed;
+          last_completion = now;
+        }
+      } while(!_end_requested && (hot_always || now - last_completion < spin_budget));
+      _polling_counters.spin_time += std::chrono::duration_cast<std::chrono::nanoseconds>(now - start).count();
+      update_cpu_time();
+      if(_end_requested)
+        break;
+
+      // Completion could have arrived before we requested the notification.
+      _connections[0].conn->notify_events(true);
+      int processed = poll_completions(false);
+      if(processed > 0) {
+        _polling_counters.hot_completions += processed;
+        continue;
+      }
+
       pollfd my_pollfd;
       my_pollfd.fd      = _connections[0].conn->completion_channel()->fd;
       my_pollfd.events  = POLLIN;
@@ -221,6 +348,7 @@ namespace rfaas {
         rc = poll(&my_pollfd, 1, 100);
         if(_end_requested) {
           spdlog::info("Background thread stops waiting for events");
+          update_cpu_time();
           return;
         }
       } while (rc == 0);
@@ -228,34 +356,12 @@ namespace rfaas {
         fprintf(stderr, "poll failed\n");
         return;
       }
-      if(!_end_requested) {
-        auto cq = _connections[0].conn->wait_events();
-        _connections[0].conn->notify_events(true);
-        _connections[0].conn->ack_events(cq, 1);
-        auto wc = _connections[0].conn->receive_wcs().poll(false);
-        for(int i = 0; i < std::get<1>(wc); ++i) {
-          uint32_t val = ntohl(std::get<0>(wc)[i].imm_data);
-          int return_val = val & 0x0000FFFF;
-          int finished_invoc_id = val >> 16;
-          auto it = _futures.find(finished_invoc_id);
-          // if it == end -> we have a bug, should never appear
-          //spdlog::info("Future for id {}", finished_invoc_id);
-          //(*it).second.set_value(return_val);
-          // FIXME: handle error
-          if(!--std::get<0>(it->second)) {
-            std::get<1>(it->second).set_value(return_val);
-
-            _connections[0].conn->receive_wcs().update_requests(_connections.size() - 1);
-            for(int i = 1; i < _connections.size(); ++i) {
-              _connections[0].conn->receive_wcs().update_requests(-1);
-            }
-          }
-        }
-        // Poll completions from past sends
-        for(auto & conn : _connections)
-          conn.conn->poll_wc(rdmalib::QueueType::SEND, false);
-      }
+      auto cq = _connections[0].conn->wait_events();
+      _connections[0].conn->ack_events(cq, 1);
+      _polling_counters.wakeups++;
+      _polling_counters.warm_completions += poll_completions(false);
     }
+    update_cpu_time();
     spdlog::info("Background thread stops waiting for events");
 
     // Wait for event
@@ -293,18 +399,244 @@ namespace rfaas {
     //spdlog::info("Background thread stops waiting for events");
   }
 
+  void executor::polling(polling_type type)
+  {
+    _polling = type;
+  }
+
+  polling_statistics executor::statistics() const
+  {
+    return _polling_counters.load();
+  }
+
+  void executor::update_cpu_time()
+  {
+    timespec ts;
+    if(!clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+      _polling_counters.cpu_time = static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+
+  int executor::select_connection()
+  {
+    // Find the thread with fewest queued invocations, starting after the previously
+    // selected one to spread invocations across all leased cores.
+    int size = _connections.size();
+    int selected = -1;
+    for(int i = 0; i < size; ++i) {
+      int idx = (_next_conn + i) % size;
+      executor_state & state = _connections[idx];
+      if(state.outstanding >= state.max_outstanding)
+        continue;
+      if(selected == -1 || state.outstanding < _connections[selected].outstanding)
+        selected = idx;
+      if(!state.outstanding)
+        break;
+    }
+    if(selected != -1)
+      _next_conn = (selected + 1) % size;
+    return selected;
+  }
+
+  bool executor::valid_input(uint32_t bytes) const
+  {
+    constexpr uint32_t header_size = rdmalib::functions::Submission::DATA_HEADER_SIZE;
+    if(bytes < header_size) {
+      spdlog::error("Input of {} bytes can't hold the invocation header of {} bytes", bytes, header_size);
+      return false;
+    }
+    return true;
+  }
+
+  pending_invocation executor::invocation(const rdmalib::impl::Buffer & in, uint32_t bytes, uint32_t slot, bool solicited)
+  {
+    // Callers reject inputs without the header.
+    constexpr uint32_t header_size = rdmalib::functions::Submission::DATA_HEADER_SIZE;
+    if(bytes - header_size <= static_cast<uint32_t>(_max_input_size))
+      return pending_invocation{in.sge(bytes, 0), slot, solicited, {0, 0, 0}};
+
+    // Send only the header, the descriptor is attached when submitting to an executor thread.
+    auto header = static_cast<rdmalib::functions::Submission*>(in.ptr());
+    header->flags |= rdmalib::functions::Submission::PULL;
+    SPDLOG_DEBUG("Input of {} bytes in slot {} exceeds the limit {}, executor will read it", bytes, slot, _max_input_size);
+    return pending_invocation{
+      in.sge(header_size, 0), slot, solicited,
+      {in.address() + header_size, in.rkey(), bytes - header_size}
+    };
+  }
+
+  rdmalib::WriteRequest executor::write_request(int conn_idx, pending_invocation && invocation)
+  {
+    executor_state & state = _connections[conn_idx];
+    uint32_t bytes = invocation.sge.array()[0].length;
+    uint64_t submission = state.input_tail++;
+    uint32_t input_slot = submission % state.input_slots;
+    if(invocation.input.size) {
+      // Descriptor has the same lifetime as the input slot - it's not overwritten
+      // before the executor receives it.
+      int idx = conn_idx * MAX_INPUT_SLOTS + submission % MAX_INPUT_SLOTS;
+      _descriptors.data()[idx] = invocation.input;
+      invocation.sge.add(_descriptors, sizeof(rdmalib::functions::InputDescriptor), idx * sizeof(rdmalib::functions::InputDescriptor));
+      bytes += sizeof(rdmalib::functions::InputDescriptor);
+    }
+    state.outstanding++;
+    return rdmalib::WriteRequest{
+      std::move(invocation.sge),
+      {state.remote_input.addr + input_slot * state.input_slot_size, state.remote_input.rkey},
+      invocation.slot,
+      bytes <= _device.max_inline_data,
+      invocation.solicited
+    };
+  }
+
+  void executor::submit(int conn_idx, pending_invocation && invocation)
+  {
+    SPDLOG_DEBUG(
+      "Submit invocation in slot {} to executor thread {}, outstanding {}",
+      invocation.slot, conn_idx, _connections[conn_idx].outstanding
+    );
+    rdmalib::WriteRequest request = write_request(conn_idx, std::move(invocation));
+    _connections[conn_idx].conn->post_write(
+      std::move(request.elems),
+      request.rbuf,
+      request.immediate,
+      request.force_inline,
+      request.solicited
+    );
+  }
+
+  void executor::dispatch(pending_invocation && invocation)
+  {
+    std::lock_guard<std::mutex> lock{_dispatch_mutex};
+    int conn_idx = select_connection();
+    if(conn_idx == -1) {
+      SPDLOG_DEBUG(
+        "All executor threads are busy, queue invocation in slot {}, pending {}",
+        invocation.slot, _pending.size()
+      );
+      _pending.push_back(std::move(invocation));
+    } else {
+      submit(conn_idx, std::move(invocation));
+    }
+  }
+
+  void executor::dispatch(std::vector<pending_invocation> && invocations)
+  {
+    std::lock_guard<std::mutex> lock{_dispatch_mutex};
+    std::vector<std::vector<rdmalib::WriteRequest>> batches(_connections.size());
+    for(auto & invocation : invocations) {
+      int conn_idx = select_connection();
+      if(conn_idx == -1) {
+        _pending.push_back(std::move(invocation));
+        continue;
+      }
+      batches[conn_idx].push_back(write_request(conn_idx, std::move(invocation)));
+    }
+    for(size_t i = 0; i < batches.size(); ++i) {
+      if(!batches[i].empty()) {
+        SPDLOG_DEBUG("Submit batch of {} invocations to executor thread {}", batches[i].size(), i);
+        _connections[i].conn->post_write_batch(batches[i]);
+      }
+    }
+    if(!_pending.empty()) {
+      SPDLOG_DEBUG("All executor threads are busy, pending invocations {}", _pending.size());
+    }
+  }
+
+  std::tuple<int, int, bool> executor::process_completion(const ibv_wc & wc)
+  {
+    uint32_t val = ntohl(wc.imm_data);
+    int return_val = val >> rdmalib::functions::Submission::STATUS_SHIFT;
+    int slot = val & rdmalib::functions::Submission::SLOT_MASK;
+    uint32_t bytes = wc.byte_len;
+    // Chunked outputs - the completion carries only the total length.
+    if(return_val & rdmalib::functions::Submission::LENGTH_REPORTED) {
+      return_val &= ~rdmalib::functions::Submission::LENGTH_REPORTED;
+      bytes = _result_lengths.data()[slot];
+    }
+
+    auto conn_it = _qp_to_conn.find(wc.qp_num);
+    if(conn_it == _qp_to_conn.end()) {
+      spdlog::error("Received completion from an unknown QP {}", wc.qp_num);
+      return std::make_tuple(slot, return_val, false);
+    }
+    // Each connection has its own receive queue, even though the completion queue is shared.
+    executor_state & state = _connections[conn_it->second];
+    state.conn->receive_wcs().update_requests(-1);
+    state.conn->receive_wcs().refill();
+    // Results are returned in the order of input slots - the oldest slot is free now.
+    state.outstanding--;
+
+    // Submit the oldest invocation waiting for resources.
+    if(!_pending.empty()) {
+      submit(conn_it->second, std::move(_pending.front()));
+      _pending.pop_front();
+    }
+
+    if(return_val != 0)
+      spdlog::error("Invocation in slot {}, failed with error {}", slot, return_val);
+    bool finished = _completions.complete(slot, return_val, bytes);
+    return std::make_tuple(slot, return_val, finished);
+  }
+
+  int executor::acquire_slot(int completions)
+  {
+    int slot = -1;
+    // Backpressure - every slot is held by an unfinished invocation or an unclaimed future.
+    while((slot = _completions.acquire(completions)) == -1)
+      poll_completions(false);
+    return slot;
+  }
+
+  int executor::poll_completions(bool blocking)
+  {
+    int processed = 0;
+    std::array<int, MAX_POLLED_COMPLETIONS> finished;
+    do {
+      int finished_count = 0;
+      {
+        // Both the poller and connections use internal arrays for work completions.
+        std::lock_guard<std::mutex> lock{_dispatch_mutex};
+        auto wc = _poller.poll(false, MAX_POLLED_COMPLETIONS);
+        processed = std::get<1>(wc);
+        for(int i = 0; i < processed; ++i) {
+          auto result = process_completion(std::get<0>(wc)[i]);
+          if(std::get<2>(result))
+            finished[finished_count++] = std::get<0>(result);
+        }
+        // Poll completions from past sends - the send queue is shared as well.
+        if(processed > 0)
+          poll_send_completions(false);
+      }
+      // Continuations might submit new invocations.
+      for(int i = 0; i < finished_count; ++i)
+        _completions.resume(finished[i]);
+    } while(blocking && !processed);
+    return processed;
+  }
+
+  int executor::poll_send_completions(bool blocking)
+  {
+    // Completions of all connections are passed to their owners by the polling connection.
+    auto wcs = _connections[0].conn->poll_wc(rdmalib::QueueType::SEND, blocking);
+    return std::get<1>(wcs);
+  }
+
   bool executor::allocate(std::string functions_path, int max_input_size,
       int hot_timeout, bool skip_manager, bool skip_resource_manger, rdmalib::Benchmarker<5> * benchmarker)
   {
     rdmalib::Buffer<char> functions = load_library(functions_path);
+    // Executor thread has to fit the descriptor of pull-mode inputs.
+    max_input_size = std::max(max_input_size, static_cast<int>(sizeof(rdmalib::functions::InputDescriptor)));
+    _max_input_size = max_input_size;
 
     if(!skip_manager) {
 
       // Measure connection time
       if(benchmarker)
         benchmarker->start();
-      bool ret = _exec_manager->connect();
-      spdlog::error("connect");
+      bool ret = true;
+      for(auto & manager : _exec_managers)
+        ret &= manager->connect();
       if(benchmarker) {
         benchmarker->end(0);
         benchmarker->start();
@@ -312,32 +644,44 @@ namespace rfaas {
       if(!ret)
         return false;
 
-      _exec_manager->request() = (rfaas::AllocationRequest) {
-        static_cast<int32_t>(_lease_id),
-        static_cast<int16_t>(hot_timeout),
-        // FIXME: timeout
-        5,
-        // FIXME: variable number of inputs
-        1,
-        max_input_size,
-        functions.data_size(),
-        _state.listen_port(),
-        ""
-      };
-      strcpy(_exec_manager->request().listen_address, _device.ip_address.c_str());
-
-      // Legacy path
-      if(skip_resource_manger) {
-
-        spdlog::error("{} {}", _numcores, _memory);
-        _exec_manager->request().cores = _numcores;
-        _exec_manager->request().memory = _memory;
+      LibraryDigest func_digest = library_digest(functions.data(), functions.data_size());
+
+      // Every node receives the same configuration and spawns its part of the lease.
+      // Threads from all nodes connect to our listening port.
+      for(size_t i = 0; i < _exec_managers.size(); ++i) {
+
+        auto & manager = _exec_managers[i];
+        manager->request() = (rfaas::AllocationRequest) {
+          static_cast<int32_t>(_nodes[i].lease_id),
+          static_cast<int16_t>(hot_timeout),
+          // FIXME: timeout
+          5,
+          // FIXME: variable number of inputs
+          1,
+          max_input_size,
+          functions.data_size(),
+          _state.listen_port(),
+          ""
+        };
+        strcpy(manager->request().listen_address, _device.ip_address.c_str());
+        manager->request().func_digest = func_digest;
+        manager->request().func_addr = functions.address();
+        manager->request().func_rkey = functions.rkey();
+
+        // Legacy path
+        if(skip_resource_manger) {
+          manager->request().cores = _nodes[i].cores;
+          manager->request().memory = _memory;
+        }
 
+        manager->send_request();
       }
-
-      if(!_exec_manager->submit()) {
+      // Managers spawn their executors in parallel.
+      ret = true;
+      for(auto & manager : _exec_managers)
+        ret &= manager->receive_response();
+      if(!ret)
         return false;
-      }
       // Measure submission time
       if(benchmarker) {
         benchmarker->end(1);
@@ -346,9 +690,9 @@ namespace rfaas {
 
     }
 
-    SPDLOG_DEBUG("Allocating {} threads on a remote executor", _numcores);
+    SPDLOG_DEBUG("Allocating {} threads on {} remote executors", _numcores, _nodes.size());
     // Now receive the connections from executors
-    uint32_t obj_size = sizeof(rdmalib::BufferInformation);
+    uint32_t obj_size = sizeof(rdmalib::functions::InputRing);
 
     // FIXME: use shared queue!
 
@@ -369,6 +713,7 @@ namespace rfaas {
           conn,
           _device.default_receive_buffer_size
         );
+        _qp_to_conn[conn->qp()->qp_num] = requested;
         this->_connections.back().conn->post_recv(_execs_buf.sge(obj_size, requested*obj_size), requested);
         // FIXME: here it won't work if rcv_bufer_size < numcores
         this->_connections.back().conn->receive_wcs().refill();
@@ -380,7 +725,10 @@ namespace rfaas {
           "[Executor] Established connection to executor {}, connection {}",
           established + 1, fmt::ptr(conn)
         );
-        conn->post_send(functions);
+        // Executors spawned by the manager load the library from its cache.
+        if(skip_manager)
+          conn->post_send(functions);
+        conn->post_send(_result_lengths_info);
         SPDLOG_DEBUG("Connected thread {}/{} and submitted function code.", established + 1, _numcores);
         ++established;
       }
@@ -402,20 +750,28 @@ namespace rfaas {
       auto wcs = this->_connections[0].conn->poll_wc(rdmalib::QueueType::RECV, true); 
       for(int i = 0; i < std::get<1>(wcs); ++i) {
         int id = std::get<0>(wcs)[i].wr_id;
+        rdmalib::functions::InputRing & ring = _execs_buf.data()[id];
         SPDLOG_DEBUG(
-          "Received buffer details for thread, addr {}, rkey {}",
-          _execs_buf.data()[id].r_addr, _execs_buf.data()[id].r_key
-        );
-        _connections[id].remote_input = rdmalib::RemoteBuffer(
-          _execs_buf.data()[id].r_addr,
-          _execs_buf.data()[id].r_key
+          "Received buffer details for thread, addr {}, rkey {}, {} slots of size {}",
+          ring.r_addr, ring.r_key, ring.slots, ring.slot_size
         );
+        executor_state & state = _connections[id];
+        state.remote_input = rdmalib::RemoteBuffer(ring.r_addr, ring.r_key);
+        state.input_slot_size = ring.slot_size;
+        state.input_slots = std::max(ring.slots, 1u);
+        state.input_tail = ring.tail;
+        // Each result consumes one of our receive requests.
+        // FIXME: the shared completion queue can still overflow with many threads
+        state.max_outstanding = std::max(1, std::min({
+          state.input_slots, MAX_INPUT_SLOTS, static_cast<int>(_device.default_receive_buffer_size)
+        }));
       }
       received += std::get<1>(wcs);
     }
 
     received = 0;
     _active_polling = false;
+    _poller = rdmalib::Poller{_connections[0].conn->qp()->recv_cq};
     // Ensure that we are able to process asynchronous replies
     // before we start any submissionk.
     _connections[0].conn->notify_events(true);
@@ -426,10 +782,15 @@ namespace rfaas {
         this
       }
     );
-    while(received < _numcores) {
-      auto wcs = this->_connections[0].conn->poll_wc(rdmalib::QueueType::SEND, true);
-      received += std::get<1>(wcs);
+    // Each thread receives the location of result lengths, and the library.
+    int messages = skip_manager ? 2 * _numcores : _numcores;
+    while(received < messages) {
+      std::lock_guard<std::mutex> lock{_dispatch_mutex};
+      received += poll_send_completions(true);
     }
+    // Invocations are not waiting for send completions.
+    for(auto & conn : _connections)
+      conn.conn->signaling(SEND_SIGNALING_PERIOD);
     // Measure initial configuration submission
     if(benchmarker) {
       benchmarker->end(3);
@@ -442,4 +803,32 @@ namespace rfaas {
     return true;
   }
 
+  std::future<bool> executor::allocate_async(std::string functions_path, int max_input_size,
+      int hot_timeout, bool skip_manager, bool skip_resource_manager)
+  {
+    return std::async(
+      std::launch::async,
+      [=]() {
+        return this->allocate(functions_path, max_input_size, hot_timeout, skip_manager, skip_resource_manager);
+      }
+    );
+  }
+
+  std::vector<bool> executor::allocate(const std::vector<executor*> & executors, std::string functions_path,
+      int max_input_size, int hot_timeout, bool skip_manager, bool skip_resource_manager)
+  {
+    std::vector<std::future<bool>> allocations;
+    allocations.reserve(executors.size());
+    for(executor* exec : executors)
+      allocations.push_back(
+        exec->allocate_async(functions_path, max_input_size, hot_timeout, skip_manager, skip_resource_manager)
+      );
+
+    std::vector<bool> results;
+    results.reserve(executors.size());
+    for(auto & allocation : allocations)
+      results.push_back(allocation.get());
+    return results;
+  }
+
 }
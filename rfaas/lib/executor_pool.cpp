@@ -0,0 +1,222 @@
+
+#include <spdlog/spdlog.h>
+
+#include <rfaas/executor_pool.hpp>
+
+namespace rfaas {
+
+  pooled_executor::pooled_executor():
+    _pool(nullptr)
+  {}
+
+  pooled_executor::pooled_executor(executor_pool* pool, const std::string & library, std::unique_ptr<executor> && exec):
+    _pool(pool),
+    _library(library),
+    _exec(std::move(exec))
+  {}
+
+  pooled_executor::~pooled_executor()
+  {
+    release();
+  }
+
+  pooled_executor::pooled_executor(pooled_executor && obj):
+    _pool(obj._pool),
+    _library(std::move(obj._library)),
+    _exec(std::move(obj._exec))
+  {
+    obj._pool = nullptr;
+  }
+
+  pooled_executor& pooled_executor::operator=(pooled_executor && obj)
+  {
+    if(this != &obj) {
+      release();
+      _pool = obj._pool;
+      _library = std::move(obj._library);
+      _exec = std::move(obj._exec);
+      obj._pool = nullptr;
+    }
+    return *this;
+  }
+
+  executor* pooled_executor::operator->() const
+  {
+    return _exec.get();
+  }
+
+  executor& pooled_executor::operator*() const
+  {
+    return *_exec;
+  }
+
+  pooled_executor::operator bool() const
+  {
+    return _exec != nullptr;
+  }
+
+  void pooled_executor::release()
+  {
+    if(_pool && _exec) {
+      _pool->release(_library, std::move(_exec));
+    }
+    _pool = nullptr;
+  }
+
+  executor_pool::executor_pool(lease_t lease, int warm_executors, int max_input_size,
+      int hot_timeout, bool skip_resource_manager, std::chrono::milliseconds idle_timeout):
+    _lease(lease),
+    _warm_executors(warm_executors),
+    _max_input_size(max_input_size),
+    _hot_timeout(hot_timeout),
+    _skip_resource_manager(skip_resource_manager),
+    _idle_timeout(idle_timeout)
+  {}
+
+  executor_pool::~executor_pool()
+  {
+    // Destruction deallocates executors and releases their leases.
+    _idle.clear();
+  }
+
+  executor_pool::lease_t executor_pool::leases(client & instance, int16_t cores, int32_t memory, device_data & dev)
+  {
+    return [&instance, &dev, cores, memory]() -> std::unique_ptr<executor> {
+      auto leased_executor = instance.lease(cores, memory, dev);
+      if(!leased_executor.has_value())
+        return nullptr;
+      return std::make_unique<executor>(std::move(leased_executor.value()));
+    };
+  }
+
+  std::unique_ptr<executor> executor_pool::lease()
+  {
+    std::lock_guard<std::mutex> lock{_lease_mutex};
+    return _lease();
+  }
+
+  std::unique_ptr<executor> executor_pool::allocate(const std::string & library)
+  {
+    std::unique_ptr<executor> exec = lease();
+    if(!exec) {
+      spdlog::error("Couldn't acquire a lease for a pooled executor!");
+      return nullptr;
+    }
+
+    if(!exec->allocate(library, _max_input_size, _hot_timeout, false, _skip_resource_manager)) {
+      spdlog::error("Couldn't allocate pooled executor for library {}", library);
+      return nullptr;
+    }
+    SPDLOG_DEBUG("Allocated new pooled executor for library {}", library);
+    return exec;
+  }
+
+  pooled_executor executor_pool::acquire(const std::string & library)
+  {
+    std::vector<std::unique_ptr<executor>> evicted;
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      expired(evicted);
+
+      auto it = _idle.find(library);
+      if(it != _idle.end() && !it->second.empty()) {
+        std::unique_ptr<executor> exec = std::move(it->second.back().exec);
+        it->second.pop_back();
+        return pooled_executor{this, library, std::move(exec)};
+      }
+    }
+    evicted.clear();
+
+    // Cold start - done without the lock since it takes milliseconds.
+    std::unique_ptr<executor> exec = allocate(library);
+    if(!exec)
+      return pooled_executor{};
+    return pooled_executor{this, library, std::move(exec)};
+  }
+
+  int executor_pool::prewarm(const std::string & library)
+  {
+    std::vector<std::unique_ptr<executor>> leased;
+    std::vector<executor*> executors;
+    for(size_t i = idle(library); i < static_cast<size_t>(_warm_executors); ++i) {
+      leased.push_back(lease());
+      if(!leased.back()) {
+        spdlog::error("Couldn't acquire a lease for a pooled executor!");
+        leased.pop_back();
+        break;
+      }
+      executors.push_back(leased.back().get());
+    }
+
+    // Cold starts of all executors are overlapped.
+    std::vector<bool> results = executor::allocate(
+      executors, library, _max_input_size, _hot_timeout, false, _skip_resource_manager
+    );
+    int allocated = 0;
+    for(size_t i = 0; i < leased.size(); ++i) {
+      if(results[i]) {
+        release(library, std::move(leased[i]));
+        ++allocated;
+      } else {
+        spdlog::error("Couldn't allocate pooled executor for library {}", library);
+      }
+    }
+    return allocated;
+  }
+
+  void executor_pool::release(const std::string & library, std::unique_ptr<executor> && exec)
+  {
+    std::vector<std::unique_ptr<executor>> evicted;
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      auto & executors = _idle[library];
+      executors.push_back(idle_executor{std::move(exec), clock_t::now()});
+      // Keep the most recently used ones.
+      while(executors.size() > static_cast<size_t>(_warm_executors)) {
+        evicted.push_back(std::move(executors.front().exec));
+        executors.pop_front();
+      }
+      expired(evicted);
+    }
+  }
+
+  int executor_pool::evict()
+  {
+    std::vector<std::unique_ptr<executor>> evicted;
+    {
+      std::lock_guard<std::mutex> lock{_mutex};
+      expired(evicted);
+    }
+    return evicted.size();
+  }
+
+  size_t executor_pool::idle(const std::string & library)
+  {
+    std::lock_guard<std::mutex> lock{_mutex};
+    auto it = _idle.find(library);
+    return it != _idle.end() ? it->second.size() : 0;
+  }
+
+  void executor_pool::expired(std::vector<std::unique_ptr<executor>> & evicted)
+  {
+    if(_idle_timeout.count() <= 0)
+      return;
+
+    auto deadline = clock_t::now() - _idle_timeout;
+    for(auto it = _idle.begin(); it != _idle.end();) {
+      auto & executors = it->second;
+      while(!executors.empty() && executors.front().since < deadline) {
+        evicted.push_back(std::move(executors.front().exec));
+        executors.pop_front();
+      }
+      if(executors.empty())
+        it = _idle.erase(it);
+      else
+        ++it;
+    }
+    if(!evicted.empty())
+      SPDLOG_DEBUG("Evicting {} idle executors", evicted.size());
+  }
+
+}
+
@@ -27,7 +27,9 @@ mgr_cfg='
     "use_docker": false,
     "repetitions": 1000,
     "warmup_iters": 0,
-    "pin_threads": false
+    "pin_threads": false,
+    "standby_executors": 0,
+    "dispatcher": false
   }
 }
 '
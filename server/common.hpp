@@ -7,6 +7,10 @@
 
 namespace executor {
 
+  // Each executor thread writes its totals to a separate cache line of the manager's buffer.
+  static constexpr int ACCOUNTING_SLOTS = 128;
+  static constexpr int ACCOUNTING_SLOT_SIZE = 64;
+
   struct ManagerConnection {
     std::string addr;
     int port;
@@ -15,6 +19,27 @@ namespace executor {
     uint32_t r_key;
   };
 
+  // Lease details sent to an executor process started in advance.
+  struct StandbyAllocation {
+    static constexpr int ADDRESS_LENGTH = 16;
+    static constexpr int PATH_LENGTH = 64;
+    static constexpr int MAX_CORES = 64;
+
+    char client_address[ADDRESS_LENGTH];
+    int32_t client_port;
+    int32_t cores;
+    int32_t input_size;
+    int32_t func_size;
+    int32_t timeout;
+    int32_t mgr_secret;
+    uint64_t accounting_addr;
+    uint32_t accounting_rkey;
+    char func_file[PATH_LENGTH];
+    // Cores assigned by the manager, empty when threads are not pinned.
+    int32_t pinned_cores_count;
+    int16_t pinned_cores[MAX_CORES];
+  };
+
 }
 
 #endif
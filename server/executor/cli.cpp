@@ -4,6 +4,7 @@
 #include <thread>
 #include <climits>
 #include <sys/time.h>
+#include <unistd.h>
 
 #include <signal.h>
 #include <cxxopts.hpp>
@@ -24,6 +25,18 @@ int main(int argc, char ** argv)
   else
     spdlog::set_level(spdlog::level::info);
   spdlog::set_pattern("[%H:%M:%S:%f] [T %t] [%l] %v ");
+
+  // Executor started in advance by the manager - prepare the device and wait for a lease.
+  std::unique_ptr<server::StandbyDevice> device;
+  if(opts.standby) {
+    device.reset(new server::StandbyDevice{opts.mgr_address});
+    spdlog::info("Standby executor waits for a lease");
+    if(!server::receive_allocation(STDIN_FILENO, opts)) {
+      spdlog::info("Standby executor closes without a lease");
+      return 0;
+    }
+  }
+
   spdlog::info(
     "Executing serverless-rdma executor with {} cores! Waiting for client at {}:{}",
     opts.fast_executors, opts.address, opts.port
@@ -50,15 +63,21 @@ int main(int argc, char ** argv)
   server::FastExecutors executor(
     opts.address, opts.port,
     opts.func_size,
+    opts.func_file,
     opts.fast_executors,
     opts.msg_size,
     opts.recv_buffer_size,
     opts.max_inline_data,
-    opts.pin_threads,
-    mgr
+    mgr,
+    opts.polling_manager == server::Options::PollingMgr::DISPATCHER
   );
 
-  executor.allocate_threads(opts.timeout, opts.repetitions + opts.warmup_iters);
+  // Without cores assigned by the manager, threads are pinned to consecutive cores.
+  if(opts.cores.empty() && opts.pin_threads != -1) {
+    for(int i = 0; i < opts.fast_executors; ++i)
+      opts.cores.push_back(opts.pin_threads + i);
+  }
+  executor.allocate_threads(opts.timeout, opts.repetitions + opts.warmup_iters, opts.cores);
 
   executor.close();
   return 0;
@@ -0,0 +1,259 @@
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include <rdmalib/rdmalib.hpp>
+#include <rdmalib/util.hpp>
+
+#include "dispatcher.hpp"
+#include "fast_executor.hpp"
+
+namespace server {
+
+  static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futex word must be a plain 32-bit integer");
+
+  static uint32_t* futex_word(std::atomic<uint32_t> & word)
+  {
+    return reinterpret_cast<uint32_t*>(&word);
+  }
+
+  Mailbox::Mailbox(int capacity):
+    _head(0),
+    _tail(0),
+    _sleeping(0)
+  {
+    uint32_t size = 1;
+    while(size < static_cast<uint32_t>(capacity))
+      size <<= 1;
+    _wcs.resize(size);
+    _mask = size - 1;
+  }
+
+  bool Mailbox::push(const ibv_wc & wc)
+  {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if(tail - _head.load(std::memory_order_acquire) > _mask)
+      return false;
+    _wcs[tail & _mask] = wc;
+    // Sequentially consistent - the worker checks the tail after announcing that it sleeps.
+    _tail.store(tail + 1, std::memory_order_seq_cst);
+    if(_sleeping.load(std::memory_order_seq_cst) && _sleeping.exchange(0, std::memory_order_seq_cst))
+      syscall(SYS_futex, futex_word(_sleeping), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    return true;
+  }
+
+  int Mailbox::pop(ibv_wc* wcs, int count)
+  {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    uint32_t tail;
+    int spins = 0;
+    while((tail = _tail.load(std::memory_order_acquire)) == head) {
+      if(++spins < SPIN_ITERATIONS)
+        continue;
+      _sleeping.store(1, std::memory_order_seq_cst);
+      if(_tail.load(std::memory_order_seq_cst) == head)
+        // Returns immediately when the dispatcher has already cleared the word.
+        syscall(SYS_futex, futex_word(_sleeping), FUTEX_WAIT_PRIVATE, 1, nullptr, nullptr, 0);
+      _sleeping.store(0, std::memory_order_relaxed);
+      spins = 0;
+    }
+
+    int available = std::min(static_cast<uint32_t>(count), tail - head);
+    for(int i = 0; i < available; ++i)
+      wcs[i] = _wcs[(head + i) & _mask];
+    _head.store(head + available, std::memory_order_release);
+    return available;
+  }
+
+  Dispatcher::Dispatcher(int workers, int recv_buffer_size, int max_inline_data, const executor::ManagerConnection & mgr_conn):
+    _workers(workers),
+    _recv_buffer_size(recv_buffer_size),
+    _max_inline_data(max_inline_data),
+    _mgr_conn(mgr_conn),
+    _id(nullptr),
+    _channel(nullptr),
+    _cq(nullptr),
+    _qp_nums(workers),
+    _closing(false)
+  {
+    // Each worker has at most that many receives posted, including the initial messages.
+    for(int i = 0; i < workers; ++i)
+      _mailboxes.emplace_back(new Mailbox{recv_buffer_size + 2});
+  }
+
+  Dispatcher::~Dispatcher()
+  {
+    stop();
+    if(_cq)
+      ibv_destroy_cq(_cq);
+    if(_channel)
+      ibv_destroy_comp_channel(_channel);
+    if(_id)
+      rdma_destroy_ep(_id);
+  }
+
+  bool Dispatcher::initialize(const std::string & client_addr, int port)
+  {
+    // Resolving the client's address selects the device, the same one as connections of workers.
+    rdmalib::Address addr{client_addr, port, false};
+    if(rdma_create_ep(&_id, addr.addrinfo, nullptr, nullptr)) {
+      spdlog::error("Couldn't resolve the device for dispatcher, reason {}", strerror(errno));
+      _id = nullptr;
+      return false;
+    }
+    rdmalib::impl::expect_nonnull(_channel = ibv_create_comp_channel(_id->verbs));
+    rdmalib::impl::expect_nonnull(_cq = ibv_create_cq(_id->verbs, _workers * (_recv_buffer_size + 2), nullptr, _channel, 0));
+    SPDLOG_DEBUG("Dispatcher allocated shared receive queue {} on device {}", fmt::ptr(_cq), ibv_get_device_name(_id->verbs->device));
+    return true;
+  }
+
+  ibv_cq* Dispatcher::queue() const
+  {
+    return _cq;
+  }
+
+  Mailbox & Dispatcher::mailbox(int worker)
+  {
+    return *_mailboxes[worker];
+  }
+
+  void Dispatcher::register_worker(int worker, uint32_t qp_num)
+  {
+    _qp_nums[worker].store(qp_num, std::memory_order_release);
+  }
+
+  void Dispatcher::start(int timeout)
+  {
+    _thread = std::thread{&Dispatcher::work, this, timeout};
+  }
+
+  void Dispatcher::stop()
+  {
+    _closing = true;
+    if(_thread.joinable())
+      _thread.join();
+  }
+
+  void Dispatcher::deliver(const ibv_wc & wc)
+  {
+    auto it = _workers_qps.find(wc.qp_num);
+    // Workers register when they connect - refresh our mapping.
+    if(it == _workers_qps.end()) {
+      for(int i = 0; i < _workers; ++i) {
+        uint32_t qp_num = _qp_nums[i].load(std::memory_order_acquire);
+        if(qp_num)
+          _workers_qps[qp_num] = i;
+      }
+      it = _workers_qps.find(wc.qp_num);
+      if(it == _workers_qps.end()) {
+        spdlog::error("Dispatcher received completion from an unknown QP {}", wc.qp_num);
+        return;
+      }
+    }
+    // Cannot happen - the worker doesn't post more receives than the mailbox can hold.
+    while(!_mailboxes[it->second]->push(wc))
+      SPDLOG_DEBUG("Mailbox of thread {} is full", it->second);
+  }
+
+  void Dispatcher::work(int timeout)
+  {
+    Accounting accounting{0, 0, 0, 0};
+    rdmalib::Buffer<uint64_t> accounting_buf(2);
+    // Accounting updates are always inlined.
+    int mgr_inline_data = std::max(_max_inline_data, static_cast<int>(accounting_buf.bytes()));
+    rdmalib::RDMAActive mgr_connection(_mgr_conn.addr, _mgr_conn.port, _recv_buffer_size, mgr_inline_data);
+    mgr_connection.allocate();
+    accounting_buf.register_memory(mgr_connection.pd(), IBV_ACCESS_LOCAL_WRITE);
+    // Billed in the slot following the slots of worker threads.
+    int slot = _workers;
+    rdmalib::Connection* mgr = nullptr;
+    if(mgr_connection.connect(_mgr_conn.secret)) {
+      mgr = &mgr_connection.connection();
+      mgr->signaling(Thread::SEND_SIGNALING_PERIOD);
+    } else {
+      spdlog::error("Dispatcher couldn't connect to the manager, its time is not billed!");
+    }
+    if(slot >= executor::ACCOUNTING_SLOTS)
+      spdlog::error("Dispatcher has no accounting slot, its time is not billed!");
+
+    spdlog::info("Dispatcher begins polling for {} threads with timeout {}", _workers, timeout);
+    ibv_wc wcs[MAX_POLLED_COMPLETIONS];
+    bool hot = timeout != 0;
+    auto start = std::chrono::high_resolution_clock::now();
+    int i = 0;
+    while(!_closing.load(std::memory_order_relaxed)) {
+
+      int ret = ibv_poll_cq(_cq, MAX_POLLED_COMPLETIONS, wcs);
+      if(ret < 0) {
+        spdlog::error("Dispatcher failed to poll the shared queue, errno {}", errno);
+        break;
+      }
+      if(ret > 0) {
+        for(int j = 0; j < ret; ++j)
+          deliver(wcs[j]);
+        if(timeout > 0)
+          hot = true;
+        if(hot) {
+          auto now = std::chrono::high_resolution_clock::now();
+          accounting.update_polling_time(start, now);
+          start = now;
+        }
+        i = 0;
+        continue;
+      }
+
+      if(hot) {
+        // FIXME: adjust period to the timeout
+        if(++i < HOT_POLLING_VERIFICATION_PERIOD)
+          continue;
+        auto now = std::chrono::high_resolution_clock::now();
+        auto time_passed = accounting.update_polling_time(start, now);
+        if(mgr)
+          accounting.send_update(mgr, accounting_buf, _mgr_conn, slot);
+        start = now;
+        i = 0;
+        if(timeout == -1 || time_passed < static_cast<uint32_t>(timeout))
+          continue;
+        SPDLOG_DEBUG("Dispatcher switches to warm polling after {} ns with no invocations", time_passed);
+        hot = false;
+      }
+
+      // Poll again after requesting notification - avoid missing completions that arrived before.
+      rdmalib::impl::expect_zero(ibv_req_notify_cq(_cq, 0));
+      ret = ibv_poll_cq(_cq, MAX_POLLED_COMPLETIONS, wcs);
+      for(int j = 0; j < ret; ++j)
+        deliver(wcs[j]);
+      if(ret != 0)
+        continue;
+      pollfd pfd{_channel->fd, POLLIN, 0};
+      if(poll(&pfd, 1, SLEEP_TIMEOUT_MS) > 0) {
+        ibv_cq* ev_cq = nullptr;
+        void* ev_ctx = nullptr;
+        if(!ibv_get_cq_event(_channel, &ev_cq, &ev_ctx))
+          ibv_ack_cq_events(ev_cq, 1);
+      }
+      // Time is billed only for hot polling.
+      start = std::chrono::high_resolution_clock::now();
+    }
+
+    // Submit final accounting information
+    if(mgr) {
+      mgr->signaling(1);
+      if(accounting.send_update(mgr, accounting_buf, _mgr_conn, slot, true)) {
+        while(mgr->send_outstanding() > 0)
+          mgr->poll_wc(rdmalib::QueueType::SEND, true);
+      }
+    }
+    spdlog::info("Dispatcher finished work, spent {} ns hot polling.", accounting.total_hot_polling_time);
+  }
+
+}
+
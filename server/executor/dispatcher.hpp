@@ -0,0 +1,95 @@
+
+#ifndef __SERVER_EXECUTOR_DISPATCHER_HPP__
+#define __SERVER_EXECUTOR_DISPATCHER_HPP__
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <infiniband/verbs.h>
+#include <rdma/rdma_cma.h>
+
+#include "common.hpp"
+
+namespace server {
+
+  // Single-producer, single-consumer queue of receive completions for one worker thread.
+  // The worker spins for a while, and then it sleeps on a futex until the dispatcher wakes it up.
+  struct Mailbox
+  {
+    static constexpr int SPIN_ITERATIONS = 1000;
+
+    Mailbox(int capacity);
+
+    Mailbox(const Mailbox &) = delete;
+    Mailbox& operator=(const Mailbox &) = delete;
+
+    // Called only by the dispatcher, returns false when the mailbox is full.
+    bool push(const ibv_wc & wc);
+    // Called only by the worker, blocks until at least one completion is available.
+    int pop(ibv_wc* wcs, int count);
+
+  private:
+    std::vector<ibv_wc> _wcs;
+    uint32_t _mask;
+    // Indices grow monotonically, and they're kept on separate cache lines.
+    alignas(64) std::atomic<uint32_t> _head;
+    alignas(64) std::atomic<uint32_t> _tail;
+    // Futex word, set to 1 by the worker before going to sleep.
+    alignas(64) std::atomic<uint32_t> _sleeping;
+  };
+
+  // Optional mode of executor threads - connections of all threads share one receive
+  // completion queue, and only the dispatcher thread polls it. Completions are passed
+  // to workers through mailboxes, and idle workers sleep instead of polling.
+  // The hot polling of the dispatcher is billed to its own accounting slot.
+  struct Dispatcher
+  {
+    // Polling time is checked and billed after that many empty polls.
+    static constexpr int HOT_POLLING_VERIFICATION_PERIOD = 10000;
+    static constexpr int MAX_POLLED_COMPLETIONS = 32;
+    // Interval of checking for the end of work while sleeping on the completion channel.
+    static constexpr int SLEEP_TIMEOUT_MS = 100;
+
+    Dispatcher(int workers, int recv_buffer_size, int max_inline_data, const executor::ManagerConnection & mgr_conn);
+    ~Dispatcher();
+
+    Dispatcher(const Dispatcher &) = delete;
+    Dispatcher& operator=(const Dispatcher &) = delete;
+
+    // Creates the shared queue on the device used to connect to the client.
+    bool initialize(const std::string & client_addr, int port);
+    ibv_cq* queue() const;
+    Mailbox & mailbox(int worker);
+    // Workers register their connection before connecting to the client.
+    void register_worker(int worker, uint32_t qp_num);
+    // Uses the same hot polling timeout as executor threads.
+    void start(int timeout);
+    void stop();
+
+  private:
+    int _workers;
+    int _recv_buffer_size;
+    int _max_inline_data;
+    const executor::ManagerConnection & _mgr_conn;
+    rdma_cm_id* _id;
+    ibv_comp_channel* _channel;
+    ibv_cq* _cq;
+    std::vector<std::unique_ptr<Mailbox>> _mailboxes;
+    // Written by workers, read by the dispatcher when it sees an unknown QP.
+    std::vector<std::atomic<uint32_t>> _qp_nums;
+    std::unordered_map<uint32_t, int> _workers_qps;
+    std::atomic<bool> _closing;
+    std::thread _thread;
+
+    void work(int timeout);
+    void deliver(const ibv_wc & wc);
+  };
+
+}
+
+#endif
+
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <chrono>
 #include <atomic>
 #include <ostream>
@@ -24,33 +25,170 @@
 
 namespace server {
 
-  Accounting::timepoint_t Thread::work(int invoc_id, int func_id, bool solicited, uint32_t in_size)
+  bool Thread::read_input(rfaas::pooled_buffer<char> & buf, const rdmalib::functions::InputDescriptor & input)
   {
+    int32_t id = conn->post_read(buf.sge(input.size, 0), {input.r_address, input.r_key});
+    if(id == -1)
+      return false;
+    // Completions of earlier result writes can be returned first.
+    while(true) {
+      auto wcs = conn->poll_wc(rdmalib::QueueType::SEND, true, 1);
+      if(std::get<1>(wcs) <= 0)
+        return false;
+      ibv_wc & wc = std::get<0>(wcs)[0];
+      if(static_cast<uint32_t>(wc.wr_id) == static_cast<uint32_t>(id))
+        return wc.status == IBV_WC_SUCCESS;
+    }
+  }
+
+  void Thread::reserve_send_buffer(int idx)
+  {
+    // Usually, the result has been delivered long before the buffer is reused.
+    while(!conn->send_finished(_send_posted[idx])) {
+      SPDLOG_DEBUG("Thread {} waits for the transfer from output buffer {}", id, idx);
+      if(std::get<1>(conn->poll_wc(rdmalib::QueueType::SEND, true)) < 0)
+        break;
+    }
+    _large_outputs[idx] = rfaas::pooled_buffer<char>{};
+  }
+
+  bool Thread::send_result(const rdmalib::impl::Buffer & output, uint32_t offset, uint32_t out_size, const rdmalib::functions::Submission & header, uint32_t slot)
+  {
+    bool solicited = header.flags & rdmalib::functions::Submission::SOLICITED;
+    // Send back: the value of immediate write
+    // lower 24 bits - completion slot of the client
+    // highest 8 bits - return value (0 on no error)
+    if(out_size <= OUTPUT_CHUNK_SIZE) {
+      bool inlined = out_size <= max_inline_data;
+      // Inlined data is copied when posting - only other writes have to be signaled
+      // to know when the buffer can be reused.
+      conn->post_write(
+        output.sge(out_size, offset),
+        {header.r_address, header.r_key},
+        (0 << rdmalib::functions::Submission::STATUS_SHIFT) | slot,
+        inlined,
+        solicited,
+        !inlined
+      );
+      return !inlined;
+    }
+
+    // Chunks are posted without waiting - writes are delivered in order,
+    // and the client is notified after the last one.
+    SPDLOG_DEBUG("Thread {} sends output of size {} in chunks", id, out_size);
+    for(uint32_t pos = 0; pos < out_size; pos += OUTPUT_CHUNK_SIZE) {
+      uint32_t chunk = std::min(OUTPUT_CHUNK_SIZE, out_size - pos);
+      conn->post_write(output.sge(chunk, offset + pos), {header.r_address + pos, header.r_key});
+    }
+    // Requests complete in order - the signaled length write covers all chunks.
+    send_length(out_size, 0, header, slot, true);
+    return true;
+  }
+
+  bool Thread::send_length(uint32_t length, uint32_t status, const rdmalib::functions::Submission & header, uint32_t slot, bool signaled)
+  {
+    bool solicited = header.flags & rdmalib::functions::Submission::SOLICITED;
+    if(header.flags & rdmalib::functions::Submission::SHARED_SLOT) {
+      conn->post_write(
+        {},
+        {header.r_address, header.r_key},
+        (status << rdmalib::functions::Submission::STATUS_SHIFT) | slot,
+        false,
+        solicited,
+        signaled
+      );
+      return signaled;
+    }
+
+    bool inlined = sizeof(uint32_t) <= max_inline_data;
+    _result_length.data()[_send_buffer] = length;
+    conn->post_write(
+      _result_length.sge(sizeof(uint32_t), _send_buffer * sizeof(uint32_t)),
+      {_result_lengths.addr + slot * sizeof(uint32_t), _result_lengths.rkey},
+      ((status | rdmalib::functions::Submission::LENGTH_REPORTED) << rdmalib::functions::Submission::STATUS_SHIFT) | slot,
+      inlined,
+      solicited,
+      signaled || !inlined
+    );
+    return signaled || !inlined;
+  }
+
+  Accounting::timepoint_t Thread::work(uint32_t slot, uint32_t in_size)
+  {
+    // Invocations arrive in the order of slots - the client doesn't overwrite
+    // the slot before receiving the result.
+    char* input_slot = static_cast<char*>(rcv.ptr()) + _input_head * _input_slot_size;
+    _input_head = (_input_head + 1) % _input_slots;
+
     // FIXME: load func ptr
-    rdmalib::functions::Submission* header = reinterpret_cast<rdmalib::functions::Submission*>(rcv.ptr());
-    auto ptr = _functions.function(func_id);
+    rdmalib::functions::Submission* header = reinterpret_cast<rdmalib::functions::Submission*>(input_slot);
+    bool solicited = header->flags & rdmalib::functions::Submission::SOLICITED;
 
-    SPDLOG_DEBUG("Thread {} begins work! Executing function {} with size {}, invoc id {}, solicited reply? {}",
-      id, _functions._names[func_id], in_size, invoc_id, solicited
+    SPDLOG_DEBUG("Thread {} begins work! Executing function {} with size {}, invoc id {}, slot {}, solicited reply? {}",
+      id, _functions._names[header->func_id], in_size, header->invocation_id, slot, solicited
     );
     auto start = std::chrono::high_resolution_clock::now();
+
     // Data to ignore header passed in the buffer
-    uint32_t out_size = (*ptr)(rcv.data(), in_size, send.ptr());
+    void* input = input_slot + rdmalib::functions::Submission::DATA_HEADER_SIZE;
+    rfaas::pooled_buffer<char> pulled_input;
+    if(header->flags & rdmalib::functions::Submission::PULL) {
+      auto descriptor = *reinterpret_cast<rdmalib::functions::InputDescriptor*>(input);
+      SPDLOG_DEBUG("Thread {} reads input of size {} from the client", id, descriptor.size);
+      pulled_input = _buffers->acquire<char>(descriptor.size, 0);
+      if(!read_input(pulled_input, descriptor)) {
+        spdlog::error("Thread {} failed to read input of invocation {}", id, header->invocation_id);
+        conn->post_write(
+          {},
+          {header->r_address, header->r_key},
+          (rdmalib::functions::Submission::INPUT_READ_FAILED << rdmalib::functions::Submission::STATUS_SHIFT) | slot,
+          false,
+          solicited
+        );
+        return std::chrono::high_resolution_clock::now();
+      }
+      input = pulled_input.data();
+      in_size = descriptor.size;
+    }
+
+    // Output buffers are reused in a round-robin order.
+    _send_buffer = (_send_buffer + 1) % SEND_BUFFERS;
+    reserve_send_buffer(_send_buffer);
+
+    // Function can produce as much output as the client can receive.
+    // Larger buffers are allocated only for outputs that don't fit into our buffer -
+    // the function returns the required size, and it's invoked again.
+    rdmalib::impl::Buffer* output = &send;
+    uint32_t offset = _send_buffer * _send_buffer_size;
+    uint32_t capacity = std::min(header->r_size, _send_buffer_size);
+    uint32_t out_size = _functions.invoke(header->func_id, input, in_size, static_cast<char*>(output->ptr()) + offset, capacity);
+    if(out_size > capacity && out_size <= header->r_size) {
+      SPDLOG_DEBUG("Thread {} repeats function with output buffer of size {}", id, out_size);
+      _large_outputs[_send_buffer] = _buffers->acquire<char>(out_size, 0);
+      output = &_large_outputs[_send_buffer];
+      offset = 0;
+      capacity = out_size;
+      out_size = _functions.invoke(header->func_id, input, in_size, output->ptr(), capacity);
+    }
     SPDLOG_DEBUG("Thread {} finished work!", id);
 
-    // Send back: the value of immediate write
-    // first 16 bytes - invocation id
-    // second 16 bytes - return value (0 on no error)
-    conn->post_write(
-      send.sge(out_size, 0),
-      {header->r_address, header->r_key},
-      (invoc_id << 16) | 0,
-      out_size <= max_inline_data,
-      solicited
-    );
+    bool pending;
+    if(out_size > capacity) {
+      spdlog::error(
+        "Thread {} output of size {} does not fit into client's buffer of size {}",
+        id, out_size, header->r_size
+      );
+      // The client learns the required size and can repeat the invocation with a larger buffer.
+      pending = send_length(out_size, rdmalib::functions::Submission::OUTPUT_TOO_LARGE, *header, slot);
+    } else {
+      pending = send_result(*output, offset, out_size, *header, slot);
+    }
+    // Inlined writes are unsignaled and might never complete while we wait - but their
+    // data has been copied already, and the buffer can be reused immediately.
+    _send_posted[_send_buffer] = pending ? conn->send_posted() : 0;
     auto end = std::chrono::high_resolution_clock::now();
     _accounting.update_execution_time(start, end);
-    _accounting.send_updated_execution(_mgr_connection, _accounting_buf, _mgr_conn);
+    _accounting.send_update(_mgr_connection, _accounting_buf, _mgr_conn, id);
     //int cpu = sched_getcpu();
     //spdlog::info("Execution + sent took {} us on {} CPU", std::chrono::duration_cast<std::chrono::microseconds>(end-start).count(), cpu);
     return end;
@@ -76,26 +214,17 @@ namespace server {
             spdlog::error("Failed work completion! Reason: {}", ibv_wc_status_str(wc->status));
             continue;
           }
-          int info = ntohl(wc->imm_data);
-          int func_id = info & invocation_mask;
-          int invoc_id = info >> 16;
-          bool solicited = info & solicited_mask;
-          SPDLOG_DEBUG(
-            "Thread {} Invoc id {} Execute func {} Repetition {}",
-            id, invoc_id, func_id, repetitions
-          );
+          uint32_t slot = ntohl(wc->imm_data) & rdmalib::functions::Submission::SLOT_MASK;
+          SPDLOG_DEBUG("Thread {} Slot {} Repetition {}", id, slot, repetitions);
 
           // Measure hot polling time until we started execution
           auto now = std::chrono::high_resolution_clock::now();
-          auto func_end = work(invoc_id, func_id, solicited,
-              wc->byte_len - rdmalib::functions::Submission::DATA_HEADER_SIZE
-          );
+          auto func_end = work(slot, wc->byte_len - rdmalib::functions::Submission::DATA_HEADER_SIZE);
           _accounting.update_polling_time(start, now);
           i = 0;
           start = func_end;
 
           //sum += server_processing_times.end();
-          conn->poll_wc(rdmalib::QueueType::SEND, true);
           repetitions += 1;
         }
         this->conn->receive_wcs().refill();
@@ -106,7 +235,7 @@ namespace server {
       if(i == HOT_POLLING_VERIFICATION_PERIOD) {
         auto now = std::chrono::high_resolution_clock::now();
         auto time_passed = _accounting.update_polling_time(start, now);
-        _accounting.send_updated_polling(_mgr_connection, _accounting_buf, _mgr_conn);
+        _accounting.send_update(_mgr_connection, _accounting_buf, _mgr_conn, id);
         start = now;
 
         if(_polling_state != PollingState::HOT_ALWAYS && time_passed >= timeout) {
@@ -140,19 +269,12 @@ namespace server {
             spdlog::error("Failed work completion! Reason: {}", ibv_wc_status_str(wc->status));
             continue;
           }
-          int info = ntohl(wc->imm_data);
-          int func_id = info & invocation_mask;
-          bool solicited = info & solicited_mask;
-          int invoc_id = info >> 16;
-          SPDLOG_DEBUG(
-            "Thread {} Invoc id {} Execute func {} Repetition {}",
-            id, invoc_id, func_id, repetitions
-          );
+          uint32_t slot = ntohl(wc->imm_data) & rdmalib::functions::Submission::SLOT_MASK;
+          SPDLOG_DEBUG("Thread {} Slot {} Repetition {}", id, slot, repetitions);
 
-          work(invoc_id, func_id, solicited, wc->byte_len - rdmalib::functions::Submission::DATA_HEADER_SIZE);
+          work(slot, wc->byte_len - rdmalib::functions::Submission::DATA_HEADER_SIZE);
 
           //sum += server_processing_times.end();
-          conn->poll_wc(rdmalib::QueueType::SEND, true);
           repetitions += 1;
         }
         this->conn->receive_wcs().refill();
@@ -174,25 +296,91 @@ namespace server {
     SPDLOG_DEBUG("Thread {} Stopped warm polling", id);
   }
 
+  void Thread::dispatched()
+  {
+    SPDLOG_DEBUG("Thread {} Begins receiving invocations from the dispatcher", id);
+    Mailbox & mailbox = _dispatcher->mailbox(id);
+    ibv_wc wcs[Dispatcher::MAX_POLLED_COMPLETIONS];
+
+    while(repetitions < max_repetitions) {
+
+      // Polling time is billed by the dispatcher.
+      int count = mailbox.pop(wcs, Dispatcher::MAX_POLLED_COMPLETIONS);
+      this->conn->receive_wcs().update_requests(-count);
+      for(int i = 0; i < count; ++i) {
+
+        ibv_wc* wc = &wcs[i];
+        if(wc->status) {
+          spdlog::error("Failed work completion! Reason: {}", ibv_wc_status_str(wc->status));
+          continue;
+        }
+        uint32_t slot = ntohl(wc->imm_data) & rdmalib::functions::Submission::SLOT_MASK;
+        SPDLOG_DEBUG("Thread {} Slot {} Repetition {}", id, slot, repetitions);
+
+        work(slot, wc->byte_len - rdmalib::functions::Submission::DATA_HEADER_SIZE);
+        repetitions += 1;
+      }
+      this->conn->receive_wcs().refill();
+    }
+    SPDLOG_DEBUG("Thread {} Stopped receiving invocations", id);
+  }
+
   void Thread::thread_work(int timeout)
   {
-    rdmalib::RDMAActive mgr_connection(_mgr_conn.addr, _mgr_conn.port, _recv_buffer_size, max_inline_data);
+    if(core != -1) {
+      spdlog::info("Pin thread {} to core {}", id, core);
+      cpu_set_t cpuset;
+      CPU_ZERO(&cpuset);
+      CPU_SET(core, &cpuset);
+      rdmalib::impl::expect_zero(pthread_setaffinity_np(
+        pthread_self(),
+        sizeof(cpu_set_t), &cpuset
+      ));
+    }
+    // Buffers are placed on the node of the pinned core, otherwise on the device node.
+    rdmalib::NumaPolicy numa_policy = core != -1 ?
+      rdmalib::NumaPolicy::LOCAL_THREAD : rdmalib::NumaPolicy::LOCAL_DEVICE;
+    send.set_numa_policy(numa_policy);
+    rcv.set_numa_policy(numa_policy);
+
+    // Accounting updates are always inlined.
+    int mgr_inline_data = std::max(max_inline_data, static_cast<uint32_t>(_accounting_buf.bytes()));
+    rdmalib::RDMAActive mgr_connection(_mgr_conn.addr, _mgr_conn.port, _recv_buffer_size, mgr_inline_data);
     mgr_connection.allocate();
     this->_mgr_connection = &mgr_connection.connection();
-    _accounting_buf.register_memory(mgr_connection.pd(), IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_ATOMIC);
+    _accounting_buf.register_memory(mgr_connection.pd(), IBV_ACCESS_LOCAL_WRITE);
     if(!mgr_connection.connect(_mgr_conn.secret))
       return;
+    if(id >= executor::ACCOUNTING_SLOTS)
+      spdlog::error("Thread {} has no accounting slot, its time is not billed!", id);
+    // Nobody waits for accounting updates - completions are only needed to reclaim the queue.
+    mgr_connection.connection().signaling(SEND_SIGNALING_PERIOD);
     spdlog::info("Thread {} Established connection to the manager!", id);
 
     rdmalib::RDMAActive active(addr, port, _recv_buffer_size, max_inline_data);
     rdmalib::Buffer<char> func_buffer(_functions.memory(), _functions.size());
 
+    if(_dispatcher)
+      active.share_receive_queue(_dispatcher->queue());
     active.allocate();
     this->conn = &active.connection();
+    // Completions of our receives are routed by the QP number.
+    if(_dispatcher)
+      _dispatcher->register_worker(id, this->conn->qp()->qp_num);
+    rfaas::buffer_pool buffers{active.pd(), IBV_ACCESS_LOCAL_WRITE, numa_policy};
+    this->_buffers = &buffers;
     // Receive function data from the client - this WC must be posted first
     // We do it before connection to ensure that client does not start sending before us
-    func_buffer.register_memory(active.pd(), IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
-    this->conn->post_recv(func_buffer);
+    int messages = 1;
+    if(_functions.needs_transfer()) {
+      func_buffer.register_memory(active.pd(), IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
+      this->conn->post_recv(func_buffer);
+      ++messages;
+    }
+    // Followed by the location of client's table of result lengths.
+    rdmalib::Buffer<rdmalib::BufferInformation> result_lengths_buf(1);
+    result_lengths_buf.register_memory(active.pd(), IBV_ACCESS_LOCAL_WRITE);
+    this->conn->post_recv(result_lengths_buf);
 
     // Request notification before connecting - avoid missing a WC!
     // Do it only when starting from a warm directly
@@ -203,7 +391,7 @@ namespace server {
     } else {
       _polling_state = PollingState::HOT;
     }
-    if(_polling_state == PollingState::WARM_ALWAYS || _polling_state == PollingState::WARM)
+    if(!_dispatcher && (_polling_state == PollingState::WARM_ALWAYS || _polling_state == PollingState::WARM))
       conn->notify_events();
 
     if(!active.connect())
@@ -211,39 +399,64 @@ namespace server {
 
     // Now generic receives for function invocations
     send.register_memory(active.pd(), IBV_ACCESS_LOCAL_WRITE);
+    _result_length.register_memory(active.pd(), IBV_ACCESS_LOCAL_WRITE);
     rcv.register_memory(active.pd(), IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
 
     spdlog::info("Thread {} Established connection to client!", id);
 
     // Send to the client information about thread buffer
-    rdmalib::Buffer<rdmalib::BufferInformation> buf(1);
+    rdmalib::Buffer<rdmalib::functions::InputRing> buf(1);
     buf.register_memory(active.pd(), IBV_ACCESS_LOCAL_WRITE);
-    buf.data()[0].r_addr = rcv.address();
-    buf.data()[0].r_key = rcv.rkey();
+    buf.data()[0] = rdmalib::functions::InputRing{
+      rcv.address(), rcv.rkey(), _input_slot_size,
+      static_cast<uint32_t>(_input_slots), static_cast<uint32_t>(_input_head), static_cast<uint32_t>(_input_head)
+    };
     SPDLOG_DEBUG("Thread {} Sends buffer details to client!", id);
     this->conn->post_send(buf, 0, buf.size() <= max_inline_data);
     this->conn->poll_wc(rdmalib::QueueType::SEND, true, 1);
     SPDLOG_DEBUG("Thread {} Sent buffer details to client!", id);
 
-    // We should have received functions data - just one message
-    this->conn->poll_wc(rdmalib::QueueType::RECV, true, 1);
+    // We should have received location of result lengths and functions data, unless it's cached
+    int received = 0;
+    while(received < messages) {
+      if(_dispatcher) {
+        ibv_wc wcs[2];
+        received += _dispatcher->mailbox(id).pop(wcs, messages - received);
+      } else
+        received += std::get<1>(this->conn->poll_wc(rdmalib::QueueType::RECV, true, messages - received));
+    }
+    _result_lengths = rdmalib::RemoteBuffer(result_lengths_buf.data()[0].r_addr, result_lengths_buf.data()[0].r_key);
     _functions.process_library();
 
+    // Results are not awaited - send completions are reaped by the connection when the queue
+    // is running out of space, or when an output buffer is reused before its transfer finished.
+    this->conn->signaling(SEND_SIGNALING_PERIOD);
+
     this->conn->receive_wcs().refill();
     spdlog::info("Thread {} begins work with timeout {}", id, timeout);
 
     // FIXME: catch interrupt handler here
     while(repetitions < max_repetitions) {
-      if(_polling_state == PollingState::HOT || _polling_state == PollingState::HOT_ALWAYS)
+      if(_dispatcher)
+        dispatched();
+      else if(_polling_state == PollingState::HOT || _polling_state == PollingState::HOT_ALWAYS)
         hot(timeout);
       else
         warm();
     }
 
     // Submit final accounting information
-    _accounting.send_updated_execution(_mgr_connection, _accounting_buf, _mgr_conn, true, false);
-    _accounting.send_updated_polling(_mgr_connection, _accounting_buf, _mgr_conn, true, false);
-    mgr_connection.connection().poll_wc(rdmalib::QueueType::SEND, true, 2);
+    // The final write must be signaled to know when all updates have been delivered.
+    mgr_connection.connection().signaling(1);
+    if(_accounting.send_update(_mgr_connection, _accounting_buf, _mgr_conn, id, true)) {
+      while(mgr_connection.connection().send_outstanding() > 0)
+        mgr_connection.connection().poll_wc(rdmalib::QueueType::SEND, true);
+    }
+    // State of functions is released by the thread that created it.
+    _functions.finalize();
+    // Return the memory before the pool is destroyed.
+    for(auto & large_output : _large_outputs)
+      large_output = rfaas::pooled_buffer<char>{};
     spdlog::info(
       "Thread {} finished work, spent {} ns hot polling and {} ns computation, {} executions.",
       id, _accounting.total_hot_polling_time , _accounting.total_execution_time, repetitions
@@ -254,26 +467,36 @@ namespace server {
 
   FastExecutors::FastExecutors(std::string client_addr, int port,
       int func_size,
+      const std::string & func_file,
       int numcores,
       int msg_size,
       int recv_buf_size,
       int max_inline_data,
-      int pin_threads,
-      const executor::ManagerConnection & mgr_conn
+      const executor::ManagerConnection & mgr_conn,
+      bool dispatcher
   ):
     _closing(false),
     _numcores(numcores),
-    _max_repetitions(0),
-    _pin_threads(pin_threads)
+    _max_repetitions(0)
     //_mgr_conn(mgr_conn)
   {
+    if(dispatcher) {
+      _dispatcher.reset(new Dispatcher{numcores, recv_buf_size, max_inline_data, mgr_conn});
+      if(!_dispatcher->initialize(client_addr, port)) {
+        spdlog::error("Couldn't initialize the dispatcher, threads poll for invocations on their own");
+        _dispatcher.reset();
+      }
+    }
+
     // Reserve place to ensure that no reallocations happen
     _threads_data.reserve(numcores);
-    for(int i = 0; i < numcores; ++i)
+    for(int i = 0; i < numcores; ++i) {
       _threads_data.emplace_back(
-        client_addr, port, i, func_size, msg_size,
+        client_addr, port, i, func_size, func_file, msg_size,
         recv_buf_size, max_inline_data, mgr_conn
       );
+      _threads_data.back()._dispatcher = _dispatcher.get();
+    }
   }
 
   FastExecutors::~FastExecutors()
@@ -300,6 +523,8 @@ namespace server {
       if(thread.joinable())
         thread.join();
     SPDLOG_DEBUG("Finished wait on {} threads", _threads.size());
+    if(_dispatcher)
+      _dispatcher->stop();
 
     for(auto & thread : _threads_data)
       spdlog::info("Thread {} Repetitions {} Avg time {} ms",
@@ -310,27 +535,23 @@ namespace server {
     _closing = true;
   }
 
-  void FastExecutors::allocate_threads(int timeout, int iterations)
+  void FastExecutors::allocate_threads(int timeout, int iterations, const std::vector<int> & cores)
   {
-    int pin_threads = _pin_threads;
+    if(!cores.empty() && cores.size() < static_cast<size_t>(_numcores))
+      spdlog::warn("Only {} cores for {} threads, the remaining threads are not pinned", cores.size(), _numcores);
+    // Threads receive even the initial messages from the client through the dispatcher.
+    if(_dispatcher)
+      _dispatcher->start(timeout);
     for(int i = 0; i < _numcores; ++i) {
       _threads_data[i].max_repetitions = iterations;
+      // Threads pin themselves before allocating any memory.
+      if(static_cast<size_t>(i) < cores.size())
+        _threads_data[i].core = cores[i];
       _threads.emplace_back(
         &Thread::thread_work,
         &_threads_data[i],
         timeout
       );
-      // FIXME: make sure that native handle is actually from pthreads
-      if(pin_threads != -1) {
-        spdlog::info("Pin thread to core {}", pin_threads);
-        cpu_set_t cpuset;
-        CPU_ZERO(&cpuset);
-        CPU_SET(pin_threads++, &cpuset);
-        rdmalib::impl::expect_zero(pthread_setaffinity_np(
-          _threads[i].native_handle(),
-          sizeof(cpu_set_t), &cpuset
-        ));
-      }
     }
   }
 
@@ -3,6 +3,7 @@
 #define __SERVER_FASTEXECUTORS_HPP__
 
 #include "rdmalib/rdmalib.hpp"
+#include <algorithm>
 #include <chrono>
 #include <vector>
 #include <thread>
@@ -13,8 +14,11 @@
 #include <rdmalib/connection.hpp>
 #include <rdmalib/functions.hpp>
 
+#include <rfaas/buffer_pool.hpp>
+
 #include "functions.hpp"
 #include "common.hpp"
+#include "dispatcher.hpp"
 #include <spdlog/spdlog.h>
 
 using namespace std::chrono_literals;
@@ -42,27 +46,6 @@ namespace server {
       total_execution_time += diff;
     }
 
-    inline void send_updated_execution(
-      rdmalib::Connection* mgr_connection, rdmalib::Buffer<uint64_t> & _accounting_buf,
-      const executor::ManagerConnection & _mgr_conn,
-      bool force = false,
-      bool wait = true
-    )
-    {
-      if(force || execution_time > BILLING_GRANULARITY) {
-        mgr_connection->post_atomic_fadd(
-          _accounting_buf,
-          { _mgr_conn.r_addr + 8, _mgr_conn.r_key},
-          execution_time
-        ); 
-        //spdlog::error("Send exec {}", execution_time);
-        if(wait)
-          mgr_connection->poll_wc(rdmalib::QueueType::SEND, true);
-        //spdlog::error("Send exec {} done", execution_time);
-        execution_time = 0;
-      }
-    }
-
     inline uint32_t update_polling_time(timepoint_t start, timepoint_t end)
     {
       uint32_t time_passed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
@@ -72,28 +55,30 @@ namespace server {
       return time_passed;
     }
 
-    inline void send_updated_polling(
+    // Writes the totals to the thread's slot in the manager, at most once per billing period.
+    // Writes are inlined and unsignaled - invocations never wait for them.
+    // Returns false when nothing has been written.
+    inline bool send_update(
       rdmalib::Connection* mgr_connection, rdmalib::Buffer<uint64_t> & _accounting_buf,
-      const executor::ManagerConnection & _mgr_conn,
-      bool force = false,
-      bool wait = true
+      const executor::ManagerConnection & _mgr_conn, int slot,
+      bool force = false
     )
     {
-      if(force || hot_polling_time > BILLING_GRANULARITY) {
-        // Can happen when we didn't got into polling and were stopped right after execution
-        if(hot_polling_time == 0)
-          return;
-        mgr_connection->post_atomic_fadd(
-          _accounting_buf,
-          { _mgr_conn.r_addr, _mgr_conn.r_key},
-          hot_polling_time
-        ); 
-        //spdlog::error("Send poll {}", hot_polling_time);
-        if(wait)
-          mgr_connection->poll_wc(rdmalib::QueueType::SEND, true);
-        //spdlog::error("Send poll {} done", hot_polling_time);
-        hot_polling_time = 0;
-      }
+      if(slot >= executor::ACCOUNTING_SLOTS)
+        return false;
+      if(!force && execution_time + hot_polling_time <= BILLING_GRANULARITY)
+        return false;
+
+      _accounting_buf.data()[0] = total_hot_polling_time;
+      _accounting_buf.data()[1] = total_execution_time;
+      mgr_connection->post_write(
+        _accounting_buf,
+        { _mgr_conn.r_addr + slot * executor::ACCOUNTING_SLOT_SIZE, _mgr_conn.r_key},
+        true
+      );
+      execution_time = 0;
+      hot_polling_time = 0;
+      return true;
     }
   };
 
@@ -107,52 +92,109 @@ namespace server {
   // FIXME: is not movable or copyable at the moment
   struct Thread {
 
+    // The next invocation can be executed while the previous results are still transferred.
+    constexpr static int SEND_BUFFERS = 2;
+    // Clients can queue that many invocations, unless we post fewer receives.
+    constexpr static int INPUT_SLOTS = 4;
 
-    constexpr static int invocation_mask = 0x00007FFF;
-    constexpr static int solicited_mask = 0x00008000;
     Functions _functions;
     std::string addr;
     int port;
     uint32_t  max_inline_data;
     int id, repetitions;
     int max_repetitions;
+    // Pinned core, -1 when the thread is not pinned.
+    int core;
     int _recv_buffer_size;
     uint64_t sum;
-    rdmalib::Buffer<char> send, rcv;
+    // Ring of SEND_BUFFERS output buffers, each of the size of the input buffer.
+    rdmalib::Buffer<char> send;
+    // Ring of input slots, each with the submission header followed by input data.
+    rdmalib::Buffer<char> rcv;
+    uint32_t _input_slot_size;
+    int _input_slots;
+    // Slot of the next invocation.
+    int _input_head;
+    uint32_t _send_buffer_size;
+    // Output buffer of the current invocation.
+    int _send_buffer;
+    // Value of send_posted after the last signaled write reading from each output buffer,
+    // zero when the NIC doesn't read from the buffer anymore.
+    uint64_t _send_posted[SEND_BUFFERS];
     rdmalib::Connection* conn;
+    // When set, receive completions are delivered by the dispatcher.
+    Dispatcher* _dispatcher;
+    // Inputs of pull-mode invocations and outputs larger than the send buffer.
+    // Allocated in thread_work.
+    rfaas::buffer_pool* _buffers;
+    // Replaces the output buffer with the same index, and it's kept
+    // until the buffer is reused.
+    rfaas::pooled_buffer<char> _large_outputs[SEND_BUFFERS];
     rdmalib::Connection* _mgr_connection;
     const executor::ManagerConnection & _mgr_conn;
     Accounting _accounting;
     rdmalib::Buffer<uint64_t> _accounting_buf;
+    // Client's table of result lengths, indexed by completion slot.
+    rdmalib::RemoteBuffer _result_lengths;
+    // One entry for each output buffer.
+    rdmalib::Buffer<uint32_t> _result_length;
     // FIXME: Adjust to billing granularity
     constexpr static int HOT_POLLING_VERIFICATION_PERIOD = 10000;
+    // Only every Nth result write generates a send completion.
+    constexpr static int SEND_SIGNALING_PERIOD = 16;
+    // Outputs larger than that are written in multiple chunks.
+    constexpr static uint32_t OUTPUT_CHUNK_SIZE = 1 << 20;
     PollingState _polling_state;
 
     Thread(std::string addr, int port, int id, int functions_size,
+        const std::string & functions_file,
         int buf_size, int recv_buffer_size, int max_inline_data,
         const executor::ManagerConnection & mgr_conn):
-      _functions(functions_size),
+      _functions(functions_size, functions_file),
       addr(addr),
       port(port),
       max_inline_data(max_inline_data),
       id(id),
       repetitions(0),
       max_repetitions(0),
+      core(-1),
       _recv_buffer_size(recv_buffer_size),
       sum(0),
-      send(buf_size),
-      rcv(buf_size, rdmalib::functions::Submission::DATA_HEADER_SIZE),
+      send(buf_size * SEND_BUFFERS),
+      rcv((buf_size + rdmalib::functions::Submission::DATA_HEADER_SIZE) * INPUT_SLOTS),
+      _input_slot_size(buf_size + rdmalib::functions::Submission::DATA_HEADER_SIZE),
+      // Each queued invocation consumes one receive request.
+      _input_slots(std::max(1, std::min(INPUT_SLOTS, recv_buffer_size))),
+      _input_head(0),
+      _send_buffer_size(buf_size),
+      _send_buffer(0),
+      _send_posted{},
       // +1 to handle batching of functions work completions + initial code submission
       conn(nullptr),
+      _dispatcher(nullptr),
+      _buffers(nullptr),
       _mgr_conn(mgr_conn),
       _accounting({0,0,0,0}),
-      _accounting_buf(1)
+      // Totals of polling and execution time.
+      _accounting_buf(2),
+      _result_length(SEND_BUFFERS)
     {
     }
 
-    Accounting::timepoint_t work(int invoc_id, int func_id, bool solicited, uint32_t in_size);
+    Accounting::timepoint_t work(uint32_t slot, uint32_t in_size);
+    // Blocks until the input of a pull-mode invocation is read from the client.
+    bool read_input(rfaas::pooled_buffer<char> & buf, const rdmalib::functions::InputDescriptor & input);
+    // Waits only if the write from the buffer has not completed yet.
+    void reserve_send_buffer(int idx);
+    // Both return true when the write reads from the output buffer after posting.
+    // Such writes are always signaled - otherwise we couldn't wait for them.
+    bool send_result(const rdmalib::impl::Buffer & output, uint32_t offset, uint32_t out_size, const rdmalib::functions::Submission & header, uint32_t slot);
+    // Completes the invocation by writing the length to the client's table, unless the slot is shared.
+    bool send_length(uint32_t length, uint32_t status, const rdmalib::functions::Submission & header, uint32_t slot, bool signaled = false);
     void hot(uint32_t hot_timeout);
     void warm();
+    // Processes invocations passed by the dispatcher, sleeps when there are none.
+    void dispatched();
     void thread_work(int timeout);
   };
 
@@ -160,27 +202,31 @@ namespace server {
 
     std::vector<Thread> _threads_data;
     std::vector<std::thread> _threads;
+    // Destroyed after threads are joined - their connections use its queue.
+    std::unique_ptr<Dispatcher> _dispatcher;
     bool _closing;
     int _numcores;
     int _max_repetitions;
     int _warmup_iters;
-    int _pin_threads;
     //const ManagerConnection & _mgr_conn;
 
     FastExecutors(
       std::string client_addr, int port,
       int function_size,
+      const std::string & function_file,
       int numcores,
       int msg_size,
       int recv_buf_size,
       int max_inline_data,
-      int pin_threads,
-      const executor::ManagerConnection & mgr_conn
+      const executor::ManagerConnection & mgr_conn,
+      // Single thread polls for invocations of all threads.
+      bool dispatcher = false
     );
     ~FastExecutors();
 
     void close();
-    void allocate_threads(int, int);
+    // Thread i is pinned to cores[i], threads are not pinned when the list is empty.
+    void allocate_threads(int timeout, int iterations, const std::vector<int> & cores);
   };
 
 }
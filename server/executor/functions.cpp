@@ -1,10 +1,13 @@
 
 #include <algorithm>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 
 #include <spdlog/spdlog.h>
 
+#include <rdmalib/functions.hpp>
 #include <rdmalib/util.hpp>
 #include "functions.hpp"
 
@@ -54,10 +57,22 @@ namespace server {
     std::sort(names.begin(), names.end());
   }
 
-  Functions::Functions(size_t size):
+  Functions::Functions(size_t size, const std::string & file):
     _size(size),
-    _library_handle(nullptr)
+    _library_handle(nullptr),
+    _from_file(!file.empty())
   {
+    // Library cached by the executor manager is mapped directly.
+    if(_from_file) {
+      rdmalib::impl::expect_nonnegative(_fd = open(file.c_str(), O_RDONLY));
+      struct stat st;
+      rdmalib::impl::expect_zero(fstat(_fd, &st));
+      _size = st.st_size;
+      _memory_handle = mmap(NULL, _size, PROT_READ, MAP_SHARED, _fd, 0);
+      rdmalib::impl::expect_true(_memory_handle != MAP_FAILED);
+      return;
+    }
+
     // FIXME: works only on Linux
     rdmalib::impl::expect_nonnegative(_fd = memfd_create("libfunction", 0));
     rdmalib::impl::expect_zero(ftruncate(_fd, size));
@@ -69,9 +84,16 @@ namespace server {
 
   Functions::~Functions()
   {
+    finalize();
     munmap(_memory_handle, _size);
     if(_library_handle)
       dlclose(_library_handle);
+    close(_fd);
+  }
+
+  bool Functions::needs_transfer() const
+  {
+    return !_from_file;
   }
 
   void Functions::process_library()
@@ -89,7 +111,37 @@ namespace server {
       [](){ spdlog::error(dlerror()); }
     );
     extract_symbols(_library_handle, _names);
+    _stateful = rdmalib::functions::remove_hooks(_names);
     _functions.resize(_names.size(), nullptr);
+    _states.resize(_names.size(), nullptr);
+    _finalizers.resize(_names.size(), nullptr);
+
+    for(size_t i = 0; i < _names.size(); ++i) {
+      if(!_stateful[i])
+        continue;
+      std::string init_name = _names[i] + rdmalib::functions::INIT_SUFFIX;
+      auto init = reinterpret_cast<InitType>(dlsym(_library_handle, init_name.c_str()));
+      if(!init) {
+        _stateful[i] = false;
+        continue;
+      }
+      SPDLOG_DEBUG("Initialize state of function {}", _names[i]);
+      _states[i] = (*init)();
+      std::string finalize_name = _names[i] + rdmalib::functions::FINALIZE_SUFFIX;
+      _finalizers[i] = dlsym(_library_handle, finalize_name.c_str());
+    }
+  }
+
+  void Functions::finalize()
+  {
+    for(size_t i = 0; i < _stateful.size(); ++i) {
+      if(_stateful[i] && _finalizers[i]) {
+        SPDLOG_DEBUG("Finalize state of function {}", _names[i]);
+        (*reinterpret_cast<FinalizeType>(_finalizers[i]))(_states[i]);
+      }
+      _stateful[i] = false;
+      _states[i] = nullptr;
+    }
   }
 
   size_t Functions::size() const
@@ -109,5 +161,13 @@ namespace server {
     }
     return reinterpret_cast<FuncType>(_functions[idx]);
   }
+
+  uint32_t Functions::invoke(int idx, void* input, uint32_t size, void* output, uint32_t capacity)
+  {
+    FuncType ptr = function(idx);
+    if(_stateful[idx])
+      return (*reinterpret_cast<StatefulFuncType>(_functions[idx]))(input, size, output, capacity, _states[idx]);
+    return (*ptr)(input, size, output, capacity);
+  }
 }
 
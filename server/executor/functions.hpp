@@ -17,19 +17,40 @@ namespace server {
     void* _memory_handle;
     size_t _size;
     void* _library_handle;
+    bool _from_file;
     // FIXME: small vector?
     std::vector<std::string> _names;
     std::vector<void*> _functions;
-
-    typedef uint32_t (*FuncType)(void*, uint32_t, void*);
-
-    Functions(size_t size);
+    // Functions with the optional hooks <name>_init and <name>_finalize.
+    // The state returned by the init hook is passed to each invocation,
+    // and the finalize hook releases it. Hooks are not listed in _names.
+    std::vector<bool> _stateful;
+    std::vector<void*> _states;
+    std::vector<void*> _finalizers;
+
+    // Functions receive the capacity of the output buffer. When the output doesn't fit,
+    // they write nothing and return the required size.
+    typedef uint32_t (*FuncType)(void*, uint32_t, void*, uint32_t);
+    typedef uint32_t (*StatefulFuncType)(void*, uint32_t, void*, uint32_t, void*);
+    typedef void* (*InitType)();
+    typedef void (*FinalizeType)(void*);
+
+    // Library is received into memory file, unless it's already available in a file.
+    Functions(size_t size, const std::string & file = "");
     ~Functions();
 
+    // The library has to be written to memory() before processing.
+    bool needs_transfer() const;
+    // Runs init hooks, called by the thread using the library.
+    // Threads can share one copy of the library when it's mapped from the manager's cache,
+    // and then global variables of the library are shared as well.
     void process_library();
+    // Runs finalize hooks, called at the latest when the library is unloaded.
+    void finalize();
     size_t size() const;
     void* memory() const;
     FuncType function(int idx);
+    uint32_t invoke(int idx, void* input, uint32_t size, void* output, uint32_t capacity);
   };
 
 }
@@ -13,13 +13,15 @@ namespace server {
       ("p,port", "Use selected port", cxxopts::value<int>()->default_value("0"))
       ("cheap", "Number of cheap executors", cxxopts::value<int>()->default_value("0"))
       ("fast", "Number of fast executors", cxxopts::value<int>()->default_value("1"))
-      ("polling-mgr", "Polling manager: server, thread, server-notify", cxxopts::value<std::string>()->default_value("server"))
+      ("polling-mgr", "Polling manager: server, thread, server-notify, dispatcher", cxxopts::value<std::string>()->default_value("server"))
       ("polling-type", "Polling type: wc (work completions), dram", cxxopts::value<std::string>()->default_value("wc"))
       ("warmup-iters", "Number of warm-up iterations", cxxopts::value<int>()->default_value("1"))
       ("pin-threads", "Pin worker threads to CPU cores", cxxopts::value<int>()->default_value("-1"))
+      ("cores", "Pin worker threads to the selected CPU cores", cxxopts::value<std::vector<int>>())
       ("max-inline-data", "Maximum size of inlined message", cxxopts::value<int>()->default_value("0"))
       ("x,requests", "Size of recv buffer", cxxopts::value<int>()->default_value("32"))
       ("func-size", "Size of functions library", cxxopts::value<int>())
+      ("func-file", "Load functions library from file instead of receiving it", cxxopts::value<std::string>()->default_value(""))
       ("timeout", "Timeout for switching hot to warm polling; -1 always hot, 0 always warm", cxxopts::value<int>())
       ("s,size", "Packet size", cxxopts::value<int>()->default_value("1"))
       ("r,repetitions", "Repetitions to execute", cxxopts::value<int>()->default_value("1"))
@@ -30,11 +32,12 @@ namespace server {
       ("mgr-secret", "Use selected port", cxxopts::value<int>())
       ("mgr-buf-addr", "Use selected port", cxxopts::value<uint64_t>())
       ("mgr-buf-rkey", "Use selected port", cxxopts::value<uint32_t>())
+      ("standby", "Start in advance and wait for lease details on standard input", cxxopts::value<bool>()->default_value("false"))
     ;
     auto parsed_options = options.parse(argc, argv);
 
     Options result;
-    result.address = parsed_options["address"].as<std::string>();
+    result.standby = parsed_options["standby"].as<bool>();
     result.port = parsed_options["port"].as<int>();
     result.cheap_executors = parsed_options["cheap"].as<int>();
     result.fast_executors = parsed_options["fast"].as<int>();
@@ -44,15 +47,23 @@ namespace server {
     result.warmup_iters = parsed_options["warmup-iters"].as<int>();
     result.verbose = parsed_options["verbose"].as<bool>();
     result.pin_threads = parsed_options["pin-threads"].as<int>();
+    if(parsed_options.count("cores"))
+      result.cores = parsed_options["cores"].as<std::vector<int>>();
     result.max_inline_data = parsed_options["max-inline-data"].as<int>();
-    result.func_size = parsed_options["func-size"].as<int>();
-    result.timeout = parsed_options["timeout"].as<int>();
+    result.func_file = parsed_options["func-file"].as<std::string>();
 
     result.mgr_address = parsed_options["mgr-address"].as<std::string>();
     result.mgr_port = parsed_options["mgr-port"].as<int>();
-    result.mgr_secret = parsed_options["mgr-secret"].as<int>();
-    result.accounting_buffer_addr = parsed_options["mgr-buf-addr"].as<uint64_t>();
-    result.accounting_buffer_rkey = parsed_options["mgr-buf-rkey"].as<uint32_t>();
+
+    // Standby executors receive the lease details later.
+    if(!result.standby) {
+      result.address = parsed_options["address"].as<std::string>();
+      result.func_size = parsed_options["func-size"].as<int>();
+      result.timeout = parsed_options["timeout"].as<int>();
+      result.mgr_secret = parsed_options["mgr-secret"].as<int>();
+      result.accounting_buffer_addr = parsed_options["mgr-buf-addr"].as<uint64_t>();
+      result.accounting_buffer_rkey = parsed_options["mgr-buf-rkey"].as<uint32_t>();
+    }
 
     std::string polling_mgr = parsed_options["polling-mgr"].as<std::string>();
     if(polling_mgr == "server") {
@@ -61,6 +72,8 @@ namespace server {
       result.polling_manager = Options::PollingMgr::SERVER_NOTIFY;
     } else if(polling_mgr == "thread") {
       result.polling_manager = Options::PollingMgr::THREAD;
+    } else if(polling_mgr == "dispatcher") {
+      result.polling_manager = Options::PollingMgr::DISPATCHER;
     } else {
       throw std::runtime_error("Unrecognized choice for polling-mgr option: " + polling_mgr);
     }
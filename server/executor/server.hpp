@@ -29,7 +29,9 @@ namespace server {
     enum class PollingMgr {
       SERVER=0,
       SERVER_NOTIFY,
-      THREAD
+      THREAD,
+      // Single thread polls for invocations of all threads.
+      DISPATCHER
     };
 
     enum class PollingType {
@@ -45,8 +47,10 @@ namespace server {
     int repetitions;
     int warmup_iters;
     int pin_threads;
+    std::vector<int> cores;
     int max_inline_data;
     int func_size;
+    std::string func_file;
     int timeout;
     bool verbose;
     PollingMgr polling_manager;
@@ -57,10 +61,24 @@ namespace server {
     int mgr_secret;
     uint64_t accounting_buffer_addr;
     uint32_t accounting_buffer_rkey;
+    bool standby;
   };
 
   Options opts(int argc, char ** argv);
 
+  // Keeps the RDMA device open and its protection domain allocated
+  // while a standby executor waits for the lease.
+  struct StandbyDevice {
+    rdma_event_channel* _ec;
+    rdma_cm_id* _id;
+
+    StandbyDevice(const std::string & address);
+    ~StandbyDevice();
+  };
+
+  // Blocks until the manager sends lease details, and updates options.
+  bool receive_allocation(int fd, Options & opts);
+
   //struct InvocationStatus {
   //  rdmalib::Connection* connection;
   //  std::atomic<int> active_threads;
@@ -0,0 +1,79 @@
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#include <rdma/rdma_cma.h>
+#include <spdlog/spdlog.h>
+
+#include <rdmalib/rdmalib.hpp>
+#include <rdmalib/util.hpp>
+
+#include "server.hpp"
+#include "common.hpp"
+
+namespace server {
+
+  StandbyDevice::StandbyDevice(const std::string & address):
+    _ec(nullptr),
+    _id(nullptr)
+  {
+    // Binding to the local address opens the device and allocates the default
+    // protection domain of rdmacm. All connections created later on the same device
+    // reuse it, as long as this identifier is alive.
+    rdmalib::impl::expect_nonnull(_ec = rdma_create_event_channel());
+    rdmalib::impl::expect_zero(rdma_create_id(_ec, &_id, nullptr, RDMA_PS_TCP));
+    rdmalib::Address addr{address, 0, true};
+    if(rdma_bind_addr(_id, addr.addrinfo->ai_src_addr)) {
+      spdlog::warn("Couldn't initialize device at {} in advance, reason {}", address, strerror(errno));
+      return;
+    }
+    SPDLOG_DEBUG(
+      "Initialized device {} in advance, protection domain {}",
+      ibv_get_device_name(_id->verbs->device), fmt::ptr(_id->pd)
+    );
+  }
+
+  StandbyDevice::~StandbyDevice()
+  {
+    if(_id)
+      rdma_destroy_id(_id);
+    if(_ec)
+      rdma_destroy_event_channel(_ec);
+  }
+
+  bool receive_allocation(int fd, Options & opts)
+  {
+    executor::StandbyAllocation msg;
+    size_t received = 0;
+    while(received < sizeof(msg)) {
+      ssize_t ret = read(fd, reinterpret_cast<char*>(&msg) + received, sizeof(msg) - received);
+      if(ret < 0 && errno == EINTR)
+        continue;
+      // Manager closed the pipe - executor is no longer needed.
+      if(ret <= 0)
+        return false;
+      received += ret;
+    }
+    close(fd);
+
+    msg.client_address[executor::StandbyAllocation::ADDRESS_LENGTH - 1] = '\0';
+    msg.func_file[executor::StandbyAllocation::PATH_LENGTH - 1] = '\0';
+    opts.address = msg.client_address;
+    opts.port = msg.client_port;
+    opts.fast_executors = msg.cores;
+    opts.msg_size = msg.input_size;
+    opts.func_size = msg.func_size;
+    opts.func_file = msg.func_file;
+    opts.timeout = msg.timeout;
+    opts.mgr_secret = msg.mgr_secret;
+    opts.accounting_buffer_addr = msg.accounting_addr;
+    opts.accounting_buffer_rkey = msg.accounting_rkey;
+    int pinned_cores = std::min(msg.pinned_cores_count, executor::StandbyAllocation::MAX_CORES);
+    opts.cores.assign(msg.pinned_cores, msg.pinned_cores + std::max(pinned_cores, 0));
+    return true;
+  }
+
+}
+
@@ -4,13 +4,17 @@
 
 #include <cstdint>
 
+#include "../common.hpp"
+
 namespace rfaas::executor_manager {
 
   // FIXME: Memory accounting for all clients?
-  struct Accounting {
+  // Slot of a single executor thread, written remotely with the thread's totals.
+  struct alignas(executor::ACCOUNTING_SLOT_SIZE) Accounting {
     volatile uint64_t hot_polling_time;
     volatile uint64_t execution_time; 
   };
+  static_assert(sizeof(Accounting) == executor::ACCOUNTING_SLOT_SIZE);
 
 }
 
@@ -39,6 +39,13 @@ int main(int argc, char ** argv)
   spdlog::set_pattern("[%H:%M:%S:%f] [P %P] [T %t] [%l] %v ");
   spdlog::info("Executing rFaaS executor manager!");
 
+  // Start the launcher before allocating any resources, to keep its address space small.
+  rfaas::executor_manager::Launcher launcher;
+  if(!launcher.start()) {
+    spdlog::error("Couldn't start executor launcher!");
+    return 1;
+  }
+
   // Catch SIGINT
   struct sigaction sigIntHandler;
   sigIntHandler.sa_handler = &signal_handler;
@@ -62,7 +69,7 @@ int main(int argc, char ** argv)
   }
   rfaas::executor_manager::Settings settings = rfaas::executor_manager::Settings::deserialize(in_cfg);
 
-  rfaas::executor_manager::Manager mgr{settings, opts.skip_rm};
+  rfaas::executor_manager::Manager mgr{settings, launcher, opts.skip_rm};
   instance = &mgr;
   mgr.start();
 
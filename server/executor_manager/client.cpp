@@ -4,7 +4,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
-#include <sys/wait.h>
+#include <signal.h>
 
 #include <rfaas/allocation.hpp>
 #include <rfaas/connection.hpp>
@@ -17,7 +17,7 @@ namespace rfaas::executor_manager {
   Client::Client(int id, rdmalib::Connection* conn, ibv_pd* pd, bool active): //, Accounting & _acc):
     connection(conn),
     allocation_requests(RECV_BUF_SIZE),
-    accounting(1),
+    accounting(executor::ACCOUNTING_SLOTS),
     //accounting(_acc),
     allocation_time(0),
     _active(active),
@@ -71,6 +71,16 @@ namespace rfaas::executor_manager {
     connection->receive_wcs().refill();
   }
 
+  Accounting Client::total_accounting() const
+  {
+    Accounting total{0, 0};
+    for(int i = 0; i < executor::ACCOUNTING_SLOTS; ++i) {
+      total.hot_polling_time += accounting.data()[i].hot_polling_time;
+      total.execution_time += accounting.data()[i].execution_time;
+    }
+    return total;
+  }
+
   void Client::disable(ResourceManagerConnection* res_mgr_connection)
   {
 
@@ -89,19 +99,24 @@ namespace rfaas::executor_manager {
     );
     // First, we check if the child is still alive
     if(executor) {
-      int status;
       auto b = std::chrono::high_resolution_clock::now();
-      kill(executor->id(), SIGTERM);
-      waitpid(executor->id(), &status, WUNTRACED);
+      executor->terminate(SIGTERM);
+      if(!executor->wait(TERMINATION_TIMEOUT_MS)) {
+        spdlog::warn("Executor {} of client {} didn't exit after {} ms, killing it", executor->id(), _id, TERMINATION_TIMEOUT_MS);
+        executor->terminate(SIGKILL);
+        executor->wait(TERMINATION_TIMEOUT_MS);
+      }
       auto e = std::chrono::high_resolution_clock::now();
       spdlog::info("Waited for child {} ms", std::chrono::duration_cast<std::chrono::milliseconds>(e-b).count());
       executor.reset();
     }
+    // Threads have exited - their slots are final, unless the executor had to be killed.
+    Accounting total = total_accounting();
     spdlog::info(
       "Client {} exited, time allocated {} us, polling {} us, execution {} us",
       _id, allocation_time,
-      accounting.data()[0].hot_polling_time / 1000.0,
-      accounting.data()[0].execution_time / 1000.0
+      total.hot_polling_time / 1000.0,
+      total.execution_time / 1000.0
     );
 
     if(res_mgr_connection) {
@@ -109,8 +124,8 @@ namespace rfaas::executor_manager {
       res_mgr_connection->close_lease(
         _id,
         allocation_time,
-        accounting.data()[0].execution_time,
-        accounting.data()[0].hot_polling_time
+        total.execution_time,
+        total.hot_polling_time
       );
 
     }
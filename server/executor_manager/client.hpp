@@ -23,6 +23,8 @@ namespace rfaas::executor_manager {
   struct Client
   {
     static constexpr int RECV_BUF_SIZE = 8;
+    // Executor threads submit final accounting before exiting.
+    static constexpr int TERMINATION_TIMEOUT_MS = 5000;
     rdmalib::Connection* connection;
     rdmalib::Buffer<rfaas::AllocationRequest> allocation_requests;
     std::unique_ptr<ActiveExecutor> executor;
@@ -36,6 +38,8 @@ namespace rfaas::executor_manager {
     Client& operator=(Client &&);
     ~Client();
     void reload_queue();
+    // Sum of all thread slots.
+    Accounting total_accounting() const;
     void disable(ResourceManagerConnection* res_mgr_connection);
     bool active();
 
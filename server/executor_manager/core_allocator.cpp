@@ -0,0 +1,196 @@
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+#include <dirent.h>
+#include <sched.h>
+
+#include <spdlog/spdlog.h>
+
+#include "core_allocator.hpp"
+
+namespace rfaas::executor_manager {
+
+  // Parses the kernel's CPU list format, e.g., "0-3,8,10-11".
+  static std::vector<int> parse_cpulist(const std::string & list)
+  {
+    std::vector<int> cpus;
+    std::stringstream ss{list};
+    std::string range;
+    while(std::getline(ss, range, ',')) {
+      if(range.empty() || range == "\n")
+        continue;
+      size_t pos = range.find('-');
+      int begin = std::stoi(range.substr(0, pos));
+      int end = pos == std::string::npos ? begin : std::stoi(range.substr(pos + 1));
+      for(int cpu = begin; cpu <= end; ++cpu)
+        cpus.push_back(cpu);
+    }
+    return cpus;
+  }
+
+  PinnedCores::PinnedCores():
+    _allocator(nullptr)
+  {}
+
+  PinnedCores::PinnedCores(CoreAllocator* allocator, std::vector<int> && cores):
+    _allocator(allocator),
+    _cores(std::move(cores))
+  {}
+
+  PinnedCores::~PinnedCores()
+  {
+    release();
+  }
+
+  PinnedCores::PinnedCores(PinnedCores && obj):
+    _allocator(obj._allocator),
+    _cores(std::move(obj._cores))
+  {
+    obj._allocator = nullptr;
+    obj._cores.clear();
+  }
+
+  PinnedCores& PinnedCores::operator=(PinnedCores && obj)
+  {
+    if(this != &obj) {
+      release();
+      _allocator = obj._allocator;
+      _cores = std::move(obj._cores);
+      obj._allocator = nullptr;
+      obj._cores.clear();
+    }
+    return *this;
+  }
+
+  const std::vector<int> & PinnedCores::cores() const
+  {
+    return _cores;
+  }
+
+  bool PinnedCores::empty() const
+  {
+    return _cores.empty();
+  }
+
+  void PinnedCores::release()
+  {
+    if(_allocator && !_cores.empty())
+      _allocator->release(_cores);
+    _allocator = nullptr;
+    _cores.clear();
+  }
+
+  CoreAllocator::CoreAllocator(const std::string & device_name):
+    _device_node(-1),
+    _free_cores(0)
+  {
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    sched_getaffinity(0, sizeof(cpuset), &cpuset);
+
+    // Without NUMA information, all cores are placed on a single node.
+    DIR* dir = opendir("/sys/devices/system/node");
+    if(dir) {
+      while(dirent* entry = readdir(dir)) {
+        std::string name{entry->d_name};
+        if(name.rfind("node", 0) != 0 || name.length() == 4 || !std::isdigit(name[4]))
+          continue;
+        int node = std::stoi(name.substr(4));
+        std::ifstream in{"/sys/devices/system/node/" + name + "/cpulist"};
+        std::string list;
+        std::getline(in, list);
+        for(int cpu : parse_cpulist(list))
+          _core_nodes[cpu] = node;
+      }
+      closedir(dir);
+    }
+
+    for(int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if(!CPU_ISSET(cpu, &cpuset))
+        continue;
+      auto it = _core_nodes.find(cpu);
+      int node = it != _core_nodes.end() ? it->second : 0;
+      _core_nodes[cpu] = node;
+      _free[node].insert(cpu);
+      ++_free_cores;
+    }
+
+    std::ifstream in{"/sys/class/infiniband/" + device_name + "/device/numa_node"};
+    if(!(in >> _device_node))
+      _device_node = -1;
+
+    spdlog::info(
+      "Core allocator has {} cores on {} NUMA nodes, device {} is on NUMA node {}",
+      _free_cores, _free.size(), device_name, _device_node
+    );
+  }
+
+  std::vector<int> CoreAllocator::nodes_order(int cores) const
+  {
+    std::vector<int> order;
+    for(auto & [node, free] : _free)
+      if(node != _device_node)
+        order.push_back(node);
+    std::stable_sort(order.begin(), order.end(),
+      [this](int a, int b) {
+        return _free.at(a).size() > _free.at(b).size();
+      }
+    );
+    if(_free.count(_device_node))
+      order.insert(order.begin(), _device_node);
+
+    // Prefer placing the entire lease on one node.
+    auto it = std::find_if(order.begin(), order.end(),
+      [this, cores](int node) {
+        return _free.at(node).size() >= static_cast<size_t>(cores);
+      }
+    );
+    if(it != order.end())
+      std::rotate(order.begin(), it, it + 1);
+    return order;
+  }
+
+  PinnedCores CoreAllocator::allocate(int cores)
+  {
+    if(cores <= 0 || cores > _free_cores)
+      return PinnedCores{};
+
+    std::vector<int> allocated;
+    for(int node : nodes_order(cores)) {
+      auto & free = _free[node];
+      while(!free.empty() && allocated.size() < static_cast<size_t>(cores)) {
+        allocated.push_back(*free.begin());
+        free.erase(free.begin());
+      }
+      if(allocated.size() == static_cast<size_t>(cores))
+        break;
+    }
+    _free_cores -= allocated.size();
+
+    SPDLOG_DEBUG("Allocated {} cores, {} cores remain free", allocated.size(), _free_cores);
+    return PinnedCores{this, std::move(allocated)};
+  }
+
+  void CoreAllocator::release(const std::vector<int> & cores)
+  {
+    for(int core : cores)
+      _free[_core_nodes[core]].insert(core);
+    _free_cores += cores.size();
+    SPDLOG_DEBUG("Released {} cores, {} cores remain free", cores.size(), _free_cores);
+  }
+
+  int CoreAllocator::free_cores() const
+  {
+    return _free_cores;
+  }
+
+  int CoreAllocator::numa_node() const
+  {
+    return _device_node;
+  }
+
+}
+
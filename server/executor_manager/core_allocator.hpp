@@ -0,0 +1,69 @@
+
+#ifndef __SERVER_EXECUTOR_MANAGER_CORE_ALLOCATOR_HPP__
+#define __SERVER_EXECUTOR_MANAGER_CORE_ALLOCATOR_HPP__
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace rfaas::executor_manager {
+
+  struct CoreAllocator;
+
+  // Cores assigned to a single executor, returned to the allocator on destruction.
+  struct PinnedCores
+  {
+    PinnedCores();
+    PinnedCores(CoreAllocator* allocator, std::vector<int> && cores);
+    ~PinnedCores();
+
+    PinnedCores(const PinnedCores &) = delete;
+    PinnedCores& operator=(const PinnedCores &) = delete;
+    PinnedCores(PinnedCores && obj);
+    PinnedCores& operator=(PinnedCores && obj);
+
+    const std::vector<int> & cores() const;
+    bool empty() const;
+    void release();
+
+  private:
+    CoreAllocator* _allocator;
+    std::vector<int> _cores;
+  };
+
+  // Assigns disjoint sets of cores to executors on this node.
+  // Cores on the NUMA node of the RDMA device are preferred, and a lease
+  // is placed on a single NUMA node whenever possible.
+  //
+  // Accessed only by the thread processing client requests.
+  struct CoreAllocator
+  {
+    CoreAllocator(const std::string & device_name);
+
+    CoreAllocator(const CoreAllocator &) = delete;
+    CoreAllocator& operator=(const CoreAllocator &) = delete;
+
+    // Returns an empty set when there are not enough free cores.
+    PinnedCores allocate(int cores);
+    int free_cores() const;
+    int numa_node() const;
+
+  private:
+    friend struct PinnedCores;
+
+    // NUMA node of the device, -1 if unknown.
+    int _device_node;
+    // Free cores on each NUMA node, limited to the CPU affinity of the manager.
+    std::map<int, std::set<int>> _free;
+    std::map<int, int> _core_nodes;
+    int _free_cores;
+
+    void release(const std::vector<int> & cores);
+    std::vector<int> nodes_order(int cores) const;
+  };
+
+}
+
+#endif
+
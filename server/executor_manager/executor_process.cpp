@@ -1,8 +1,13 @@
 
+#include <algorithm>
+#include <cstring>
 #include <tuple>
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <signal.h>
 #include <sys/wait.h>
 
 #include <spdlog/spdlog.h>
@@ -11,6 +16,7 @@
 
 #include "manager.hpp"
 #include "executor_process.hpp"
+#include "launcher.hpp"
 #include "settings.hpp"
 #include "../common.hpp"
 
@@ -30,32 +36,39 @@ namespace rfaas::executor_manager {
     connections[pos] = connection;
   }
 
-  ProcessExecutor::ProcessExecutor(int cores, ProcessExecutor::time_t alloc_begin, pid_t pid):
+  ProcessExecutor::ProcessExecutor(int cores, ProcessExecutor::time_t alloc_begin, pid_t pid, int pidfd, Launcher & launcher):
     ActiveExecutor(cores),
-    _pid(pid)
+    _pid(pid),
+    _pidfd(pidfd),
+    _launcher(&launcher)
   {
     _allocation_begin = alloc_begin;
     // FIXME: remove after connection
     _allocation_finished = _allocation_begin;
   }
 
+  ProcessExecutor::~ProcessExecutor()
+  {
+    if(_pidfd != -1)
+      close(_pidfd);
+  }
+
   std::tuple<ProcessExecutor::Status,int> ProcessExecutor::check() const
   {
-    int status = 0;
-    // WNOHANG - returns immediately without waiting
-    // WUNTRACED - return the status of stopped children
-    pid_t return_pid = waitpid(_pid, &status, WNOHANG | WUNTRACED);
+    // The process descriptor is readable once the process terminates.
+    pollfd pfd{_pidfd, POLLIN, 0};
+    if(poll(&pfd, 1, 0) == 0)
+      return std::make_tuple(Status::RUNNING, 0);
 
-    if(!return_pid) {
+    // Executors are children of the launcher, which reaps them.
+    std::optional<int> exit_status = _launcher->exit_status(_pid, EXIT_STATUS_TIMEOUT_MS);
+
+    if(!exit_status.has_value()) {
       return std::make_tuple(Status::RUNNING, 0);
     } else {
 
-      if(return_pid == -1 && errno == ECHILD) {
-        return std::make_tuple(Status::FINISHED, -1);
-      } else if (return_pid == -1) {
-        // Unknown problem
-        return std::make_tuple(Status::FINISHED_FAIL, -1);
-      } else if(WIFEXITED(status)) {
+      int status = exit_status.value();
+      if(WIFEXITED(status)) {
         return std::make_tuple(Status::FINISHED, WEXITSTATUS(status));
       } else if (WIFSIGNALED(status)) {
         return std::make_tuple(Status::FINISHED_FAIL, WTERMSIG(status));
@@ -66,38 +79,59 @@ namespace rfaas::executor_manager {
     }
   }
 
+  void ProcessExecutor::terminate(int signal)
+  {
+    if(_pidfd != -1)
+      syscall(SYS_pidfd_send_signal, _pidfd, signal, nullptr, 0);
+    else
+      kill(_pid, signal);
+  }
+
+  bool ProcessExecutor::wait(int timeout_ms)
+  {
+    if(_pidfd == -1)
+      return _launcher->exit_status(_pid, timeout_ms).has_value();
+
+    pollfd pfd{_pidfd, POLLIN, 0};
+    if(poll(&pfd, 1, timeout_ms) <= 0)
+      return false;
+    // The report might have been already collected by check().
+    _launcher->exit_status(_pid, EXIT_STATUS_TIMEOUT_MS);
+    return true;
+  }
+
   int ProcessExecutor::id() const
   {
     return static_cast<int>(_pid);
   }
 
+  int ProcessExecutor::fd() const
+  {
+    return _pidfd;
+  }
+
   ProcessExecutor* ProcessExecutor::spawn(
     const rfaas::AllocationRequest & request,
     const ExecutorSettings & exec,
     const executor::ManagerConnection & conn,
-    const Lease & lease
+    const Lease & lease,
+    const std::string & library,
+    const std::vector<int> & pinned_cores,
+    Launcher & launcher
   )
   {
-    static int counter = 0;
     auto begin = std::chrono::high_resolution_clock::now();
-    //spdlog::info("Child fork begins work on PID {} req {}", mypid, fmt::ptr(&request));
     std::string client_addr{request.listen_address};
     std::string client_port = std::to_string(request.listen_port);
-    //spdlog::error("Child fork begins work on PID {} req {}", mypid, fmt::ptr(&request));
     std::string client_in_size = std::to_string(request.input_buf_size);
     std::string client_func_size = std::to_string(request.func_buf_size);
     std::string client_cores = std::to_string(lease.cores);
     std::string client_timeout = std::to_string(request.hot_timeout);
-    //spdlog::error("Child fork begins work on PID {}", mypid);
     std::string executor_repetitions = std::to_string(exec.repetitions);
     std::string executor_warmups = std::to_string(exec.warmup_iters);
     std::string executor_recv_buf = std::to_string(exec.recv_buffer_size);
     std::string executor_max_inline = std::to_string(exec.max_inline_data);
-    std::string executor_pin_threads;
-    if(exec.pin_threads >= 0)
-      executor_pin_threads = std::to_string(0);//counter++);
-    else
-      executor_pin_threads = std::to_string(exec.pin_threads);
+    std::string polling_mgr = exec.dispatcher ? "dispatcher" : "thread";
     bool use_docker = exec.use_docker;
 
     std::string mgr_port = std::to_string(conn.port);
@@ -105,122 +139,222 @@ namespace rfaas::executor_manager {
     std::string mgr_buf_addr = std::to_string(conn.r_addr);
     std::string mgr_buf_rkey = std::to_string(conn.r_key);
 
-    int mypid = fork();
-    if(mypid < 0) {
-      spdlog::error("Fork failed! {}", mypid);
+    LaunchCommand command;
+    if(!use_docker) {
+      command.argv = {
+        "executor",
+        "-a", client_addr,
+        "-p", client_port,
+        "--polling-mgr", polling_mgr,
+        "-r", executor_repetitions,
+        "-x", executor_recv_buf,
+        "-s", client_in_size,
+        "--fast", client_cores,
+        "--warmup-iters", executor_warmups,
+        "--max-inline-data", executor_max_inline,
+        "--func-size", client_func_size,
+        "--func-file", library,
+        "--timeout", client_timeout,
+        "--mgr-address", conn.addr,
+        "--mgr-port", mgr_port,
+        "--mgr-secret", mgr_secret,
+        "--mgr-buf-addr", mgr_buf_addr,
+        "--mgr-buf-rkey", mgr_buf_rkey
+      };
+    } else {
+      // The cache lives in the manager's memory file - bind it into the container.
+      // Unlike a volume, a bind mount fails when the source does not exist.
+      std::string library_mount = "type=bind,readonly,source=" + library + ",target=" + DOCKER_LIBRARY_PATH;
+      command.argv = {
+        "docker_rdma_sriov", "run",
+        "--rm",
+        "--net=mynet", "-i", //"-it",
+        // FIXME: make configurable
+        "--ip=148.187.105.250",
+        // FIXME: make configurable
+        "--volume", "/users/mcopik/projects/rdma/repo/build_repo2:/opt",
+        "--mount", library_mount,
+        // FIXME: make configurable
+        "rdma-test",
+        "/opt/bin/executor",
+        "-a", client_addr,
+        "-p", client_port,
+        "--polling-mgr", polling_mgr,
+        "-r", executor_repetitions,
+        "-x", executor_recv_buf,
+        "-s", client_in_size,
+        "--fast", client_cores,
+        "--warmup-iters", executor_warmups,
+        "--max-inline-data", executor_max_inline,
+        "--func-size", client_func_size,
+        "--func-file", DOCKER_LIBRARY_PATH,
+        "--timeout", client_timeout,
+        "--mgr-address", conn.addr,
+        "--mgr-port", mgr_port,
+        "--mgr-secret", mgr_secret,
+        "--mgr-buf-addr", mgr_buf_addr,
+        "--mgr-buf-rkey", mgr_buf_rkey
+      };
+    }
+
+    if(!pinned_cores.empty()) {
+      std::string cores;
+      for(int core : pinned_cores)
+        cores += (cores.empty() ? "" : ",") + std::to_string(core);
+      command.argv.insert(command.argv.end(), {"--cores", cores});
     }
-    if(mypid == 0) {
-      mypid = getpid();
-      auto out_file = ("executor_" + std::to_string(mypid));
-
-      spdlog::info("Child fork begins work on PID {}, using Docker? {}", mypid, use_docker);
-      int fd = open(out_file.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
-      dup2(fd, 1);
-      dup2(fd, 2);
-      if(!use_docker) {
-        const char * argv[] = {
-          "executor",
-          "-a", client_addr.c_str(),
-          "-p", client_port.c_str(),
-          "--polling-mgr", "thread",
-          "-r", executor_repetitions.c_str(),
-          "-x", executor_recv_buf.c_str(),
-          "-s", client_in_size.c_str(),
-          "--pin-threads", executor_pin_threads.c_str(),
-          "--fast", client_cores.c_str(),
-          "--warmup-iters", executor_warmups.c_str(),
-          "--max-inline-data", executor_max_inline.c_str(),
-          "--func-size", client_func_size.c_str(),
-          "--timeout", client_timeout.c_str(),
-          "--mgr-address", conn.addr.c_str(),
-          "--mgr-port", mgr_port.c_str(),
-          "--mgr-secret", mgr_secret.c_str(),
-          "--mgr-buf-addr", mgr_buf_addr.c_str(),
-          "--mgr-buf-rkey", mgr_buf_rkey.c_str(),
-          nullptr
-        };
-        int ret = execvp(argv[0], const_cast<char**>(&argv[0]));
-        if(ret == -1) {
-          spdlog::error("Executor process failed {}, reason {}", errno, strerror(errno));
-          close(fd);
-          exit(1);
-        }
-      } else {
-        //const char * argv[] = {
-        //  "docker_rdma_sriov", "run",
-        //  "--rm",
-        //  "--net=mynet", "-i", //"-it",
-        //  // FIXME: make configurable
-        //  "--ip=148.187.105.220",
-        //  // FIXME: make configurable
-        //  "--volume", "/users/mcopik/projects/rdma/repo/build_repo2:/opt",
-        //  // FIXME: make configurable
-        //  "rdma-test",
-        //  "/opt/bin/executor",
-        //  "-a", client_addr.c_str(),
-        //  "-p", client_port.c_str(),
-        //  "--polling-mgr", "thread",
-        //  "-r", executor_repetitions.c_str(),
-        //  "-x", executor_recv_buf.c_str(),
-        //  "-s", client_in_size.c_str(),
-        //  "--pin-threads", "true",
-        //  "--fast", client_cores.c_str(),
-        //  "--warmup-iters", executor_warmups.c_str(),
-        //  "--max-inline-data", executor_max_inline.c_str(),
-        //  "--func-size", client_func_size.c_str(),
-        //  "--timeout", client_timeout.c_str(),
-        //  "--mgr-address", conn.addr.c_str(),
-        //  "--mgr-port", mgr_port.c_str(),
-        //  "--mgr-secret", mgr_secret.c_str(),
-        //  "--mgr-buf-addr", mgr_buf_addr.c_str(),
-        //  "--mgr-buf-rkey", mgr_buf_rkey.c_str(),
-        //  nullptr
-        //};
-        const char * argv[] = {
-          "docker_rdma_sriov", "run",
-          "--rm",
-          "--net=mynet", "-i", //"-it",
-          // FIXME: make configurable
-          "--ip=148.187.105.250",
-          // FIXME: make configurable
-          "--volume", "/users/mcopik/projects/rdma/repo/build_repo2:/opt",
-          // FIXME: make configurable
-          "rdma-test",
-          "/opt/bin/executor",
-          "-a", client_addr.c_str(),
-          "-p", client_port.c_str(),
-          "--polling-mgr", "thread",
-          "-r", executor_repetitions.c_str(),
-          "-x", executor_recv_buf.c_str(),
-          "-s", client_in_size.c_str(),
-          "--pin-threads", executor_pin_threads.c_str(),
-          "--fast", client_cores.c_str(),
-          "--warmup-iters", executor_warmups.c_str(),
-          "--max-inline-data", executor_max_inline.c_str(),
-          "--func-size", client_func_size.c_str(),
-          "--timeout", client_timeout.c_str(),
-          "--mgr-address", conn.addr.c_str(),
-          "--mgr-port", mgr_port.c_str(),
-          "--mgr-secret", mgr_secret.c_str(),
-          "--mgr-buf-addr", mgr_buf_addr.c_str(),
-          "--mgr-buf-rkey", mgr_buf_rkey.c_str(),
-          nullptr
-        };
-        int ret = execvp(argv[0], const_cast<char**>(&argv[0]));
-        if(ret == -1) {
-          spdlog::error("Executor process failed {}, reason {}", errno, strerror(errno));
-          close(fd);
-          exit(1);
-        }
 
+    LaunchedProcess process = launcher.spawn({command})[0];
+    if(process.pid == -1) {
+      spdlog::error("Couldn't start executor process!");
+      return nullptr;
+    }
+    spdlog::info("Executor process starts work on PID {}, using Docker? {}", process.pid, use_docker);
+    return new ProcessExecutor{lease.cores, begin, process.pid, process.pidfd, launcher};
+  }
+
+  ProcessExecutor* ProcessExecutor::activate(
+    StandbyExecutor & standby,
+    const rfaas::AllocationRequest & request,
+    const executor::ManagerConnection & conn,
+    const Lease & lease,
+    const std::string & library,
+    const std::vector<int> & pinned_cores,
+    Launcher & launcher
+  )
+  {
+    auto begin = std::chrono::high_resolution_clock::now();
+
+    executor::StandbyAllocation msg{};
+    strncpy(msg.client_address, request.listen_address, executor::StandbyAllocation::ADDRESS_LENGTH - 1);
+    msg.client_port = request.listen_port;
+    msg.cores = lease.cores;
+    msg.input_size = request.input_buf_size;
+    msg.func_size = request.func_buf_size;
+    msg.timeout = request.hot_timeout;
+    msg.mgr_secret = conn.secret;
+    msg.accounting_addr = conn.r_addr;
+    msg.accounting_rkey = conn.r_key;
+    strncpy(msg.func_file, library.c_str(), executor::StandbyAllocation::PATH_LENGTH - 1);
+    if(pinned_cores.size() > executor::StandbyAllocation::MAX_CORES) {
+      spdlog::error("Can't pin {} cores of standby executor {}", pinned_cores.size(), standby.pid);
+      standby.release();
+      return nullptr;
+    }
+    msg.pinned_cores_count = pinned_cores.size();
+    std::copy(pinned_cores.begin(), pinned_cores.end(), msg.pinned_cores);
+
+    // The message is smaller than PIPE_BUF - the write is atomic.
+    ssize_t ret = write(standby.control_fd, &msg, sizeof(msg));
+    close(standby.control_fd);
+    if(ret != sizeof(msg)) {
+      spdlog::error("Couldn't hand over lease to standby executor {}, reason {}", standby.pid, strerror(errno));
+      if(standby.pidfd != -1)
+        close(standby.pidfd);
+      return nullptr;
+    }
+    SPDLOG_DEBUG("Lease handed over to standby executor {}", standby.pid);
+    return new ProcessExecutor{lease.cores, begin, standby.pid, standby.pidfd, launcher};
+  }
+
+  void StandbyExecutor::release()
+  {
+    close(control_fd);
+    if(pidfd != -1)
+      close(pidfd);
+  }
+
+  StandbyExecutors::StandbyExecutors(const ExecutorSettings & exec, const std::string & mgr_address, int mgr_port, Launcher & launcher):
+    _exec(exec),
+    _mgr_address(mgr_address),
+    _mgr_port(mgr_port),
+    _launcher(launcher)
+  {}
+
+  StandbyExecutors::~StandbyExecutors()
+  {
+    // Closing the pipe terminates the process.
+    for(auto & executor : _executors)
+      executor.release();
+  }
+
+  bool StandbyExecutors::enabled() const
+  {
+    return _exec.standby_executors > 0 && !_exec.use_docker;
+  }
+
+  void StandbyExecutors::fill()
+  {
+    if(!enabled())
+      return;
+    int missing = _exec.standby_executors - static_cast<int>(_executors.size());
+    if(missing > 0)
+      spawn(missing);
+  }
+
+  std::optional<StandbyExecutor> StandbyExecutors::take()
+  {
+    while(!_executors.empty()) {
+      StandbyExecutor executor = _executors.front();
+      _executors.pop_front();
+
+      // Verify that the process did not fail in the meantime.
+      if(!_launcher.exit_status(executor.pid).has_value())
+        return executor;
+
+      spdlog::warn("Standby executor {} is no longer running", executor.pid);
+      executor.release();
+    }
+    return std::nullopt;
+  }
+
+  void StandbyExecutors::spawn(int count)
+  {
+    // Only settings independent of the lease are known now.
+    std::string executor_repetitions = std::to_string(_exec.repetitions);
+    std::string executor_warmups = std::to_string(_exec.warmup_iters);
+    std::string executor_recv_buf = std::to_string(_exec.recv_buffer_size);
+    std::string executor_max_inline = std::to_string(_exec.max_inline_data);
+    std::string polling_mgr = _exec.dispatcher ? "dispatcher" : "thread";
+    std::string mgr_port = std::to_string(_mgr_port);
+
+    // All processes are started with a single request to the launcher.
+    std::vector<LaunchCommand> commands;
+    std::vector<int> control_fds;
+    for(int i = 0; i < count; ++i) {
+      int fds[2];
+      if(pipe2(fds, O_CLOEXEC)) {
+        spdlog::error("Couldn't create control pipe for standby executor, reason {}", strerror(errno));
+        break;
       }
-      //close(fd);
-      exit(0);
+      LaunchCommand command;
+      command.argv = {
+        "executor",
+        "--standby",
+        "--polling-mgr", polling_mgr,
+        "-r", executor_repetitions,
+        "-x", executor_recv_buf,
+        "--warmup-iters", executor_warmups,
+        "--max-inline-data", executor_max_inline,
+        "--mgr-address", _mgr_address,
+        "--mgr-port", mgr_port
+      };
+      // Lease details arrive on standard input.
+      command.stdin_fd = fds[0];
+      commands.push_back(std::move(command));
+      control_fds.push_back(fds[1]);
+    }
+
+    std::vector<LaunchedProcess> processes = _launcher.spawn(commands);
+    for(size_t i = 0; i < commands.size(); ++i) {
+      close(commands[i].stdin_fd);
+      if(processes[i].pid == -1) {
+        close(control_fds[i]);
+        continue;
+      }
+      _executors.push_back(StandbyExecutor{processes[i].pid, control_fds[i], processes[i].pidfd});
+      SPDLOG_DEBUG("Started standby executor {}", processes[i].pid);
     }
-    if(counter == 36)
-      counter = 0;
-    return new ProcessExecutor{lease.cores, begin, mypid};
   }
 
 }
-
@@ -2,11 +2,16 @@
 #ifndef __SERVER_EXECUTOR_MANAGER_EXECUTOR_PROCESS_HPP__
 #define __SERVER_EXECUTOR_MANAGER_EXECUTOR_PROCESS_HPP__
 
-#include <memory>
 #include <chrono>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
 
 #include <rdmalib/connection.hpp>
 
+#include "core_allocator.hpp"
+
 namespace rfaas {
   struct AllocationRequest;
 }
@@ -18,6 +23,7 @@ namespace executor {
 namespace rfaas::executor_manager {
 
   struct ExecutorSettings;
+  struct Launcher;
   struct Lease;
 
   struct ActiveExecutor {
@@ -32,6 +38,8 @@ namespace rfaas::executor_manager {
     rdmalib::Connection** connections;
     int connections_len;
     int cores;
+    // Released when the executor is removed.
+    PinnedCores pinned_cores;
 
     ActiveExecutor(int cores):
       connections(new rdmalib::Connection*[cores]),
@@ -41,26 +49,66 @@ namespace rfaas::executor_manager {
 
     virtual ~ActiveExecutor();
     virtual int id() const = 0;
+    // Descriptor becoming readable when the executor exits.
+    virtual int fd() const = 0;
     virtual std::tuple<Status,int> check() const = 0;
+    virtual void terminate(int signal) = 0;
+    // Returns false when the executor is still running after the timeout.
+    virtual bool wait(int timeout_ms) = 0;
     void add_executor(rdmalib::Connection*);
   };
 
+  struct StandbyExecutor
+  {
+    pid_t pid;
+    // Write end of the control pipe.
+    int control_fd;
+    int pidfd;
+
+    // Closes the descriptors of a process that won't be used.
+    void release();
+  };
+
   struct ProcessExecutor : public ActiveExecutor
   {
+    static constexpr int EXIT_STATUS_TIMEOUT_MS = 100;
+    // Location of the cached functions library inside the container.
+    static constexpr const char* DOCKER_LIBRARY_PATH = "/rfaas/libfunctions.so";
+
     pid_t _pid;
+    int _pidfd;
+    Launcher* _launcher;
 
-    ProcessExecutor(int cores, time_t alloc_begin, pid_t pid);
+    ProcessExecutor(int cores, time_t alloc_begin, pid_t pid, int pidfd, Launcher & launcher);
+    ~ProcessExecutor();
 
     // FIXME: kill active executor
-    //~ProcessExecutor();
     //void close();
     int id() const override;
+    int fd() const override;
     std::tuple<Status,int> check() const override;
+    // Signals are sent through the process descriptor - the pid might have been reused.
+    void terminate(int signal) override;
+    // Collects the exit status from the launcher, which also releases its report.
+    bool wait(int timeout_ms) override;
     static ProcessExecutor* spawn(
       const rfaas::AllocationRequest & request,
       const ExecutorSettings & exec,
       const executor::ManagerConnection & conn,
-      const Lease & lease
+      const Lease & lease,
+      const std::string & library,
+      const std::vector<int> & pinned_cores,
+      Launcher & launcher
+    );
+    // Hands over the lease to a process started in advance.
+    static ProcessExecutor* activate(
+      StandbyExecutor & standby,
+      const rfaas::AllocationRequest & request,
+      const executor::ManagerConnection & conn,
+      const Lease & lease,
+      const std::string & library,
+      const std::vector<int> & pinned_cores,
+      Launcher & launcher
     );
   };
 
@@ -68,6 +116,29 @@ namespace rfaas::executor_manager {
   {
   };
 
+  // Executor processes started in advance, waiting for lease details on the control pipe.
+  // They have the device opened and the process initialized, removing
+  // the process startup from the cold start of an allocation.
+  struct StandbyExecutors
+  {
+    StandbyExecutors(const ExecutorSettings & exec, const std::string & mgr_address, int mgr_port, Launcher & launcher);
+    ~StandbyExecutors();
+
+    // Starts new processes until the configured number is reached.
+    void fill();
+    std::optional<StandbyExecutor> take();
+    bool enabled() const;
+
+  private:
+    const ExecutorSettings & _exec;
+    std::string _mgr_address;
+    int _mgr_port;
+    Launcher & _launcher;
+    std::deque<StandbyExecutor> _executors;
+
+    void spawn(int count);
+  };
+
 }
 
 #endif
@@ -0,0 +1,366 @@
+
+#include <algorithm>
+#include <csignal>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include <spdlog/spdlog.h>
+
+#include "launcher.hpp"
+
+extern char **environ;
+
+namespace rfaas::executor_manager {
+
+  struct LaunchRequest
+  {
+    int16_t commands;
+    int16_t fds;
+  };
+
+  struct LaunchCommandHeader
+  {
+    int16_t argc;
+    // Index of the passed file descriptor, -1 when not used.
+    int16_t stdin_index;
+  };
+
+  struct LaunchResponse
+  {
+    int32_t count;
+    pid_t pids[Launcher::MAX_BATCH];
+    // Index of the passed process descriptor, -1 when not available.
+    int16_t pidfds[Launcher::MAX_BATCH];
+  };
+
+  struct LaunchExit
+  {
+    pid_t pid;
+    int status;
+  };
+
+  Launcher::Launcher():
+    _pid(-1),
+    _commands(-1),
+    _events(-1)
+  {}
+
+  Launcher::~Launcher()
+  {
+    // Closing the socket terminates the helper, running executors are not affected.
+    if(_commands != -1)
+      close(_commands);
+    if(_events != -1)
+      close(_events);
+    if(_pid > 0)
+      waitpid(_pid, nullptr, 0);
+  }
+
+  bool Launcher::start()
+  {
+    int commands[2], events[2];
+    if(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, commands)) {
+      spdlog::error("Couldn't create launcher socket, reason {}", strerror(errno));
+      return false;
+    }
+    if(socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, events)) {
+      spdlog::error("Couldn't create launcher socket, reason {}", strerror(errno));
+      close(commands[0]);
+      close(commands[1]);
+      return false;
+    }
+
+    pid_t pid = fork();
+    if(pid < 0) {
+      spdlog::error("Fork of launcher failed, reason {}", strerror(errno));
+      for(int fd : {commands[0], commands[1], events[0], events[1]})
+        close(fd);
+      return false;
+    }
+    if(pid == 0) {
+      close(commands[0]);
+      close(events[0]);
+      run(commands[1], events[1]);
+      _exit(0);
+    }
+
+    close(commands[1]);
+    close(events[1]);
+    _pid = pid;
+    _commands = commands[0];
+    _events = events[0];
+    fcntl(_events, F_SETFL, fcntl(_events, F_GETFL) | O_NONBLOCK);
+    spdlog::info("Started executor launcher with PID {}", _pid);
+    return true;
+  }
+
+  std::vector<LaunchedProcess> Launcher::spawn(const std::vector<LaunchCommand> & commands)
+  {
+    std::vector<LaunchedProcess> processes;
+    processes.reserve(commands.size());
+    for(size_t i = 0; i < commands.size(); i += MAX_BATCH) {
+      int count = std::min(commands.size() - i, static_cast<size_t>(MAX_BATCH));
+      if(!spawn_batch(&commands[i], count, processes))
+        processes.resize(i + count, LaunchedProcess{-1, -1});
+    }
+    return processes;
+  }
+
+  bool Launcher::spawn_batch(const LaunchCommand* commands, int count, std::vector<LaunchedProcess> & processes)
+  {
+    std::vector<char> data(sizeof(LaunchRequest));
+    std::vector<int> fds;
+    for(int i = 0; i < count; ++i) {
+      LaunchCommandHeader header{
+        static_cast<int16_t>(commands[i].argv.size()),
+        static_cast<int16_t>(commands[i].stdin_fd != -1 ? fds.size() : -1)
+      };
+      if(commands[i].stdin_fd != -1)
+        fds.push_back(commands[i].stdin_fd);
+      const char* ptr = reinterpret_cast<const char*>(&header);
+      data.insert(data.end(), ptr, ptr + sizeof(header));
+      for(auto & arg : commands[i].argv)
+        data.insert(data.end(), arg.c_str(), arg.c_str() + arg.length() + 1);
+    }
+    if(data.size() > MAX_MESSAGE_SIZE) {
+      spdlog::error("Launch request of size {} is too large!", data.size());
+      return false;
+    }
+    LaunchRequest request{static_cast<int16_t>(count), static_cast<int16_t>(fds.size())};
+    memcpy(data.data(), &request, sizeof(request));
+
+    iovec iov{data.data(), data.size()};
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    char control[CMSG_SPACE(sizeof(int) * MAX_BATCH)] = {};
+    if(!fds.empty()) {
+      msg.msg_control = control;
+      msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+      cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+      cmsg->cmsg_level = SOL_SOCKET;
+      cmsg->cmsg_type = SCM_RIGHTS;
+      cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+      memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+    }
+    if(sendmsg(_commands, &msg, 0) == -1) {
+      spdlog::error("Couldn't send launch request, reason {}", strerror(errno));
+      return false;
+    }
+
+    LaunchResponse response;
+    iov = iovec{&response, sizeof(response)};
+    msg = msghdr{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    ssize_t ret;
+    do {
+      ret = recvmsg(_commands, &msg, MSG_CMSG_CLOEXEC);
+    } while(ret == -1 && errno == EINTR);
+
+    int pidfds[MAX_BATCH];
+    int pidfds_count = 0;
+    cmsghdr* cmsg = ret > 0 ? CMSG_FIRSTHDR(&msg) : nullptr;
+    if(cmsg && cmsg->cmsg_type == SCM_RIGHTS) {
+      pidfds_count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      memcpy(pidfds, CMSG_DATA(cmsg), sizeof(int) * pidfds_count);
+    }
+    if(ret != static_cast<ssize_t>(sizeof(response)) || response.count != count) {
+      spdlog::error("Couldn't receive launch response, reason {}", ret == -1 ? strerror(errno) : "launcher exited");
+      for(int i = 0; i < pidfds_count; ++i)
+        close(pidfds[i]);
+      return false;
+    }
+    for(int i = 0; i < count; ++i) {
+      int idx = response.pidfds[i];
+      processes.push_back(LaunchedProcess{
+        response.pids[i],
+        idx >= 0 && idx < pidfds_count ? pidfds[idx] : -1
+      });
+    }
+    return true;
+  }
+
+  std::optional<int> Launcher::exit_status(pid_t pid, int timeout_ms)
+  {
+    auto it = _exited.end();
+    while(true) {
+
+      LaunchExit event;
+      while(recv(_events, &event, sizeof(event), 0) == sizeof(event))
+        _exited[event.pid] = event.status;
+
+      it = _exited.find(pid);
+      if(it != _exited.end() || timeout_ms <= 0)
+        break;
+
+      // FIXME: the timeout is restarted after every unrelated report
+      pollfd pfd{_events, POLLIN, 0};
+      if(poll(&pfd, 1, timeout_ms) <= 0)
+        break;
+    }
+
+    if(it == _exited.end())
+      return std::nullopt;
+    int status = it->second;
+    _exited.erase(it);
+    return status;
+  }
+
+  void Launcher::run(int commands, int events)
+  {
+    // Don't outlive the manager, and leave SIGINT to the manager.
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    signal(SIGINT, SIG_IGN);
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+    int sigfd = signalfd(-1, &mask, SFD_CLOEXEC);
+
+    // Executors start with the default signal handling.
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t empty, defaults;
+    sigemptyset(&empty);
+    sigemptyset(&defaults);
+    sigaddset(&defaults, SIGINT);
+    posix_spawnattr_setsigmask(&attr, &empty);
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    std::vector<char> data(MAX_MESSAGE_SIZE);
+    char control[CMSG_SPACE(sizeof(int) * MAX_BATCH)];
+    int counter = 0;
+    pollfd fds[2] = {{commands, POLLIN, 0}, {sigfd, POLLIN, 0}};
+
+    while(true) {
+
+      if(poll(fds, 2, -1) == -1) {
+        if(errno == EINTR)
+          continue;
+        break;
+      }
+
+      if(fds[1].revents & POLLIN) {
+        signalfd_siginfo info;
+        while(read(sigfd, &info, sizeof(info)) == -1 && errno == EINTR);
+        int status;
+        pid_t pid;
+        while((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+          LaunchExit event{pid, status};
+          send(events, &event, sizeof(event), 0);
+        }
+      }
+
+      if(!(fds[0].revents & (POLLIN | POLLHUP)))
+        continue;
+
+      iovec iov{data.data(), data.size()};
+      msghdr msg{};
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      ssize_t ret = recvmsg(commands, &msg, MSG_CMSG_CLOEXEC);
+      // Manager closed the connection.
+      if(ret <= 0)
+        break;
+
+      int passed_fds[MAX_BATCH];
+      int passed_count = 0;
+      cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+      if(cmsg && cmsg->cmsg_type == SCM_RIGHTS) {
+        passed_count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        memcpy(passed_fds, CMSG_DATA(cmsg), sizeof(int) * passed_count);
+      }
+
+      LaunchRequest request;
+      memcpy(&request, data.data(), sizeof(request));
+      LaunchResponse response{};
+      int pidfds[MAX_BATCH];
+      int pidfds_count = 0;
+      response.count = std::min(static_cast<int>(request.commands), static_cast<int>(MAX_BATCH));
+      const char* ptr = data.data() + sizeof(request);
+      for(int i = 0; i < response.count; ++i) {
+
+        LaunchCommandHeader header;
+        memcpy(&header, ptr, sizeof(header));
+        ptr += sizeof(header);
+        std::vector<char*> argv;
+        for(int j = 0; j < header.argc; ++j) {
+          argv.push_back(const_cast<char*>(ptr));
+          ptr += strlen(ptr) + 1;
+        }
+        argv.push_back(nullptr);
+
+        // The output file is named after the process ID, which is known only after the spawn.
+        std::string out_file = "executor_launch_" + std::to_string(counter++);
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_addopen(&actions, 1, out_file.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+        posix_spawn_file_actions_adddup2(&actions, 1, 2);
+        if(header.stdin_index >= 0 && header.stdin_index < passed_count)
+          posix_spawn_file_actions_adddup2(&actions, passed_fds[header.stdin_index], 0);
+
+        pid_t pid;
+        int err = posix_spawnp(&pid, argv[0], &actions, &attr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        response.pidfds[i] = -1;
+        if(err) {
+          spdlog::error("Executor process failed {}, reason {}", err, strerror(err));
+          response.pids[i] = -1;
+        } else {
+          rename(out_file.c_str(), ("executor_" + std::to_string(pid)).c_str());
+          response.pids[i] = pid;
+          // The child is reaped only after this request is processed.
+          int pidfd = syscall(SYS_pidfd_open, pid, 0);
+          if(pidfd != -1) {
+            response.pidfds[i] = pidfds_count;
+            pidfds[pidfds_count++] = pidfd;
+          } else
+            spdlog::error("Couldn't open process descriptor of executor {}, reason {}", pid, strerror(errno));
+        }
+      }
+      for(int i = 0; i < passed_count; ++i)
+        close(passed_fds[i]);
+
+      iov = iovec{&response, sizeof(response)};
+      msg = msghdr{};
+      msg.msg_iov = &iov;
+      msg.msg_iovlen = 1;
+      if(pidfds_count > 0) {
+        msg.msg_control = control;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * pidfds_count);
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * pidfds_count);
+        memcpy(CMSG_DATA(cmsg), pidfds, sizeof(int) * pidfds_count);
+      }
+      sendmsg(commands, &msg, 0);
+      // The manager has its own copies now.
+      for(int i = 0; i < pidfds_count; ++i)
+        close(pidfds[i]);
+    }
+
+    posix_spawnattr_destroy(&attr);
+    close(sigfd);
+    close(commands);
+    close(events);
+  }
+
+}
+
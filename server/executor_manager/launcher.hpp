@@ -0,0 +1,74 @@
+
+#ifndef __SERVER_EXECUTOR_MANAGER_LAUNCHER_HPP__
+#define __SERVER_EXECUTOR_MANAGER_LAUNCHER_HPP__
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/types.h>
+
+namespace rfaas::executor_manager {
+
+  struct LaunchCommand
+  {
+    std::vector<std::string> argv;
+    // Duplicated as the standard input of the process, unless it's -1.
+    int stdin_fd = -1;
+  };
+
+  struct LaunchedProcess
+  {
+    // -1 when the process failed to start.
+    pid_t pid;
+    // Process descriptor opened by the launcher, -1 when not available.
+    // The launcher is the parent and doesn't reap the process before opening it,
+    // so the descriptor can't refer to a reused pid.
+    int pidfd;
+  };
+
+  // Helper process spawning executors on behalf of the manager.
+  // Forking the manager itself becomes more expensive with each registered
+  // memory region and client, and it risks copy-on-write of pinned pages.
+  // The helper is forked before any RDMA resources are allocated, and it starts
+  // executors with posix_spawn. Since the executors are its children, it reaps
+  // them and reports their exit status back to the manager.
+  //
+  // Not thread-safe, the manager uses it only from the thread processing client requests.
+  struct Launcher
+  {
+    static constexpr int MAX_BATCH = 32;
+    static constexpr int MAX_MESSAGE_SIZE = 65536;
+
+    Launcher();
+    ~Launcher();
+
+    Launcher(const Launcher &) = delete;
+    Launcher& operator=(const Launcher &) = delete;
+
+    // Must be called before the manager allocates RDMA resources.
+    bool start();
+    // Returns processes in the order of commands, the caller owns the process descriptors.
+    std::vector<LaunchedProcess> spawn(const std::vector<LaunchCommand> & commands);
+    // Returns the wait status of a process that exited.
+    // The timeout covers the delay between process termination and the report from the launcher.
+    std::optional<int> exit_status(pid_t pid, int timeout_ms = 0);
+
+  private:
+    pid_t _pid;
+    // Requests and responses.
+    int _commands;
+    // Exit notifications.
+    int _events;
+    std::unordered_map<pid_t, int> _exited;
+
+    bool spawn_batch(const LaunchCommand* commands, int count, std::vector<LaunchedProcess> & processes);
+    static void run(int commands, int events);
+  };
+
+}
+
+#endif
+
@@ -0,0 +1,125 @@
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <spdlog/spdlog.h>
+
+#include <rdmalib/buffer.hpp>
+#include <rdmalib/util.hpp>
+
+#include <rfaas/allocation.hpp>
+
+#include "library_cache.hpp"
+
+namespace rfaas::executor_manager {
+
+  // Prefix of the digest, only for logging.
+  static uint64_t digest_prefix(const rfaas::LibraryDigest & digest)
+  {
+    uint64_t prefix = 0;
+    for(int i = 0; i < 8; ++i)
+      prefix = (prefix << 8) | digest[i];
+    return prefix;
+  }
+
+  LibraryCache::LibraryCache():
+    _hits(0),
+    _misses(0)
+  {}
+
+  LibraryCache::~LibraryCache()
+  {
+    for(auto & [hash, library] : _libraries)
+      close(library.fd);
+  }
+
+  std::optional<std::string> LibraryCache::get(const rfaas::AllocationRequest & request, rdmalib::Connection* conn, ibv_pd* pd)
+  {
+    auto it = _libraries.find(request.func_digest);
+    if(it != _libraries.end() && it->second.size == request.func_buf_size) {
+      ++_hits;
+      SPDLOG_DEBUG("Library {:016x} of size {} found in cache", digest_prefix(request.func_digest), request.func_buf_size);
+      return it->second.path;
+    }
+
+    ++_misses;
+    CachedLibrary library;
+    if(!read(request, conn, pd, library))
+      return std::nullopt;
+
+    spdlog::info(
+      "Cached library {:016x} of size {}, cache has {} hits and {} misses",
+      digest_prefix(request.func_digest), request.func_buf_size, _hits, _misses
+    );
+    std::string path = library.path;
+    if(it != _libraries.end()) {
+      close(it->second.fd);
+      it->second = std::move(library);
+    } else {
+      _libraries.emplace(request.func_digest, std::move(library));
+    }
+    return path;
+  }
+
+  bool LibraryCache::read(const rfaas::AllocationRequest & request, rdmalib::Connection* conn, ibv_pd* pd, CachedLibrary & library)
+  {
+    uint32_t size = request.func_buf_size;
+    int fd = memfd_create("rfaas-library", MFD_CLOEXEC);
+    if(fd == -1 || ftruncate(fd, size)) {
+      spdlog::error("Couldn't allocate cache for library of size {}, reason {}", size, strerror(errno));
+      if(fd != -1)
+        close(fd);
+      return false;
+    }
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    rdmalib::impl::expect_true(ptr != MAP_FAILED);
+
+    bool success = false;
+    {
+      rdmalib::Buffer<char> buf(ptr, size);
+      buf.register_memory(pd, IBV_ACCESS_LOCAL_WRITE);
+
+      int32_t id = conn->post_read(buf.sge(size, 0), {request.func_addr, request.func_rkey});
+      while(id != -1) {
+        auto wcs = conn->poll_wc(rdmalib::QueueType::SEND, true, 1);
+        if(std::get<1>(wcs) <= 0)
+          break;
+        ibv_wc & wc = std::get<0>(wcs)[0];
+        if(static_cast<uint32_t>(wc.wr_id) == static_cast<uint32_t>(id)) {
+          success = wc.status == IBV_WC_SUCCESS;
+          break;
+        }
+      }
+    }
+
+    // Never cache a library under an incorrect digest - other clients would run it.
+    if(success && rfaas::library_digest(ptr, size) != request.func_digest) {
+      spdlog::error("Library of size {} does not match digest {:016x}", size, digest_prefix(request.func_digest));
+      success = false;
+    }
+    munmap(ptr, size);
+
+    if(!success) {
+      spdlog::error("Couldn't read library of size {} from client", size);
+      close(fd);
+      return false;
+    }
+
+    library.fd = fd;
+    library.size = size;
+    library.path = "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(fd);
+    return true;
+  }
+
+  int LibraryCache::hits() const
+  {
+    return _hits;
+  }
+
+  int LibraryCache::misses() const
+  {
+    return _misses;
+  }
+
+}
+
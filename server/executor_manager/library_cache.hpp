@@ -0,0 +1,57 @@
+
+#ifndef __SERVER_EXECUTOR_MANAGER_LIBRARY_CACHE_HPP__
+#define __SERVER_EXECUTOR_MANAGER_LIBRARY_CACHE_HPP__
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+
+#include <infiniband/verbs.h>
+
+#include <rdmalib/connection.hpp>
+
+#include <rfaas/allocation.hpp>
+
+namespace rfaas::executor_manager {
+
+  struct CachedLibrary
+  {
+    int fd;
+    uint32_t size;
+    // Executors open the library through our file descriptor.
+    std::string path;
+  };
+
+  // Content-addressed cache of function libraries, stored in memory files.
+  // A library is transferred from the client only once, and then it is
+  // mapped by all executors deploying the same code.
+  // Libraries are shared between clients - they're indexed by SHA-256 digests,
+  // and the digest is verified before the library is inserted.
+  // FIXME: libraries are never evicted
+  struct LibraryCache
+  {
+    LibraryCache();
+    ~LibraryCache();
+
+    LibraryCache(const LibraryCache &) = delete;
+    LibraryCache& operator=(const LibraryCache &) = delete;
+
+    // Returns the path of the library, reading it from the client on a miss.
+    std::optional<std::string> get(const rfaas::AllocationRequest & request, rdmalib::Connection* conn, ibv_pd* pd);
+
+    int hits() const;
+    int misses() const;
+
+  private:
+    std::map<rfaas::LibraryDigest, CachedLibrary> _libraries;
+    int _hits;
+    int _misses;
+
+    bool read(const rfaas::AllocationRequest & request, rdmalib::Connection* conn, ibv_pd* pd, CachedLibrary & library);
+  };
+
+}
+
+#endif
+
@@ -63,8 +63,9 @@ namespace rfaas::executor_manager {
 
   constexpr int Manager::POLLING_TIMEOUT_MS;
 
-  Manager::Manager(Settings & settings, bool skip_rm):
+  Manager::Manager(Settings & settings, Launcher & launcher, bool skip_rm):
     _client_queue(100),
+    _cores(settings.device->name),
     _ids(0),
     _res_mgr_connection(nullptr),
     _state(settings.device->ip_address, settings.rdma_device_port,
@@ -72,7 +73,9 @@ namespace rfaas::executor_manager {
     _client_responses(1),
     _settings(settings),
     _skip_rm(skip_rm),
-    _shutdown(false)
+    _shutdown(false),
+    _launcher(launcher),
+    _standby(_settings.exec, settings.device->ip_address, settings.rdma_device_port, _launcher)
   {
     if(!_skip_rm) {
       _res_mgr_connection = std::make_unique<ResourceManagerConnection>(
@@ -106,6 +109,7 @@ namespace rfaas::executor_manager {
 
     _state.register_shared_queue(0);
     _client_responses.register_memory(_state.pd(), IBV_ACCESS_LOCAL_WRITE);
+    _standby.fill();
 
     spdlog::info(
       "Begin listening at {}:{} and processing events!",
@@ -291,24 +295,72 @@ namespace rfaas::executor_manager {
 
       }
 
+      auto library = _libraries.get(client.allocation_requests.data()[wr_id], client.connection, _state.pd());
+      if(!library.has_value()) {
+        *_client_responses.data() = (LeaseStatus) {LeaseStatus::FAILED_ALLOCATE};
+        client.connection->post_send(_client_responses);
+        client.connection->receive_wcs().update_requests(-1);
+        client.connection->receive_wcs().refill();
+        client.connection->poll_wc(rdmalib::QueueType::SEND, true, 1);
+        return true;
+      }
+
       rdmalib::PrivateData<0,0,32> data;
       data.secret(client.connection->qp()->qp_num);
-      uint64_t addr = client.accounting.address(); //+ sizeof(Accounting)*i;
+      // Threads write to consecutive slots starting at this address.
+      uint64_t addr = client.accounting.address();
+
+      executor::ManagerConnection mgr_conn{
+        _settings.device->ip_address,
+        _settings.rdma_device_port,
+        data.data(), addr, client.accounting.rkey()
+      };
 
       // FIXME: Docker
       auto now = std::chrono::high_resolution_clock::now();
-      client.executor.reset(
-        ProcessExecutor::spawn(
-          client.allocation_requests.data()[wr_id],
-          _settings.exec,
-          {
-            _settings.device->ip_address,
-            _settings.rdma_device_port,
-            data.data(), addr, client.accounting.rkey()
-          },
-          lease.value()
-        )
-      );
+      PinnedCores pinned;
+      if(_settings.exec.pin_threads) {
+        pinned = _cores.allocate(lease->cores);
+        if(pinned.empty())
+          spdlog::warn("Not enough free cores for client {}, its {} threads are not pinned", client.id(), lease->cores);
+      }
+      auto standby = _standby.take();
+      if(standby.has_value()) {
+        client.executor.reset(
+          ProcessExecutor::activate(
+            standby.value(),
+            client.allocation_requests.data()[wr_id],
+            mgr_conn,
+            lease.value(),
+            library.value(),
+            pinned.cores(),
+            _launcher
+          )
+        );
+      }
+      if(!client.executor) {
+        client.executor.reset(
+          ProcessExecutor::spawn(
+            client.allocation_requests.data()[wr_id],
+            _settings.exec,
+            mgr_conn,
+            lease.value(),
+            library.value(),
+            pinned.cores(),
+            _launcher
+          )
+        );
+      }
+      if(!client.executor || !_executor_events.add_fd(client.executor->fd(), client.connection->qp()->qp_num)) {
+        client.executor.reset(nullptr);
+        *_client_responses.data() = (LeaseStatus) {LeaseStatus::FAILED_ALLOCATE};
+        client.connection->post_send(_client_responses);
+        client.connection->receive_wcs().update_requests(-1);
+        client.connection->receive_wcs().refill();
+        client.connection->poll_wc(rdmalib::QueueType::SEND, true, 1);
+        return true;
+      }
+      client.executor->pinned_cores = std::move(pinned);
       auto end = std::chrono::high_resolution_clock::now();
       spdlog::info(
         "Client {} at {}:{} has executor with {} ID and {} cores, time {} us",
@@ -323,6 +375,9 @@ namespace rfaas::executor_manager {
       client.connection->receive_wcs().refill();
 
       client.connection->poll_wc(rdmalib::QueueType::SEND, true, 1);
+
+      // Replace the used process after responding to the client.
+      _standby.fill();
       return true;
     } else {
 
@@ -335,17 +390,20 @@ namespace rfaas::executor_manager {
 
   }
 
-  void Manager::_check_executors(removals_t & removals)
+  void Manager::_check_executors()
   {
-    for(auto it = _clients.begin(); it != _clients.end(); ++it) {
+    // Only descriptors of executors that exited are reported.
+    auto [events, count] = _executor_events.poll(0);
+    for(int j = 0; j < count; ++j) {
 
-      Client & client = it->second;
-      int i = it->first;
-      if(!client.active()) {
+      uint32_t i = events[j].data.u32;
+      auto it = _clients.find(i);
+      if(it == _clients.end()) {
         continue;
       }
 
-      if(!client.executor) {
+      Client & client = it->second;
+      if(!client.active() || !client.executor) {
         continue;
       }
 
@@ -359,18 +417,21 @@ namespace rfaas::executor_manager {
 
         // FIXME: update global manager
         // send lease cancellation
+        Accounting total = client.total_accounting();
         spdlog::info(
           "Executor at client {} exited, status {}, time allocated {} us, polling {} us, execution {} us",
           i, std::get<1>(status), client.allocation_time,
-          client.accounting.data()[i].hot_polling_time / 1000.0,
-          client.accounting.data()[i].execution_time / 1000.0
+          total.hot_polling_time / 1000.0,
+          total.execution_time / 1000.0
         );
+        // Closing the process descriptor removes it from the poller.
         client.executor.reset(nullptr);
         spdlog::info("Finished cleanup");
 
         // FIXME: notify client
         client.disable(_res_mgr_connection.get());
-        removals.push_back(it);
+        spdlog::info("Remove client id {}", i);
+        _clients.erase(it);
       }
 
     }
@@ -459,7 +520,6 @@ namespace rfaas::executor_manager {
   void Manager::poll_rdma()
   {
     rdmalib::Poller recv_poller{std::get<1>(*_state.shared_queue(0))};
-    std::vector<std::unordered_map<uint32_t, Client>::iterator> removals;
     int conn_count = 0;
 
     while(!_shutdown.load()) {
@@ -487,15 +547,7 @@ namespace rfaas::executor_manager {
 
       }
 
-      _check_executors(removals);
-
-      if(removals.size()) {
-        for(auto it : removals) {
-          spdlog::info("Remove client id {}", it->first);
-          _clients.erase(it);
-        }
-        removals.clear();
-      }
+      _check_executors();
     }
     spdlog::info("Background thread stops processing RDMA events.");
     _clients.clear();
@@ -522,6 +574,7 @@ namespace rfaas::executor_manager {
     }
 
     event_poller.add_channel(client_poller, 0);
+    event_poller.add_fd(_executor_events.fd(), 2);
 
     std::vector<Client*> poll_send;
     std::vector<rdmalib::Connection*> disconnections;
@@ -575,6 +628,10 @@ namespace rfaas::executor_manager {
             }
           }
 
+        } else if(events[i].data.u32 == 2) {
+
+          _check_executors();
+
         } else {
 
           auto cq = res_mgr.wait_events();
@@ -16,10 +16,14 @@
 #include <rdmalib/rdmalib.hpp>
 #include <rdmalib/server.hpp>
 #include <rdmalib/buffer.hpp>
+#include <rdmalib/poller.hpp>
 
 #include <rfaas/allocation.hpp>
 
 #include "client.hpp"
+#include "core_allocator.hpp"
+#include "launcher.hpp"
+#include "library_cache.hpp"
 #include "settings.hpp"
 #include "common/messages.hpp"
 #include "common.hpp"
@@ -136,6 +140,8 @@ namespace rfaas::executor_manager {
     typedef std::variant<rdmalib::Connection*, Client> msg_t;
     moodycamel::BlockingReaderWriterQueue<std::tuple<Operation, msg_t>> _client_queue;
 
+    // Declared before clients since their executors return cores on destruction.
+    CoreAllocator _cores;
     std::mutex clients;
     std::unordered_map<uint32_t, Client> _clients;
     int _ids;
@@ -150,8 +156,14 @@ namespace rfaas::executor_manager {
     bool _skip_rm;
     std::atomic<bool> _shutdown;
     Leases _leases;
+    // Accessed only by the thread processing client requests.
+    LibraryCache _libraries;
+    Launcher & _launcher;
+    StandbyExecutors _standby;
+    // Process descriptors of executors, tagged with the client ID.
+    rdmalib::EventPoller _executor_events;
 
-    Manager(Settings &, bool skip_rm);
+    Manager(Settings &, Launcher &, bool skip_rm);
 
     void start();
     void listen();
@@ -161,8 +173,7 @@ namespace rfaas::executor_manager {
 
   private:
 
-    typedef std::vector<std::unordered_map<uint32_t, Client>::iterator> removals_t;
-    void _check_executors(removals_t & removals);
+    void _check_executors();
     std::tuple<Operation, msg_t>* _check_queue(bool sleep);
     void _handle_connections(msg_t & message);
     void _handle_disconnections(rdmalib::Connection* conn);
@@ -19,13 +19,18 @@ namespace rfaas::executor_manager {
     int recv_buffer_size;
     int max_inline_data;
     bool pin_threads;
+    // Executor processes started in advance.
+    int standby_executors;
+    // Executor threads don't poll - a single thread polls for all of them.
+    bool dispatcher;
 
     template <class Archive>
     void load(Archive & ar )
     {
       ar(
         CEREAL_NVP(use_docker), CEREAL_NVP(repetitions),
-        CEREAL_NVP(warmup_iters), CEREAL_NVP(pin_threads)
+        CEREAL_NVP(warmup_iters), CEREAL_NVP(pin_threads),
+        CEREAL_NVP(standby_executors), CEREAL_NVP(dispatcher)
       );
     }
   };
@@ -1,4 +1,5 @@
 
+#include <algorithm>
 #include <fstream>
 
 #include <optional>
@@ -43,17 +44,40 @@ namespace rfaas { namespace resource_manager {
     return erased ? ResultCode::OK : ResultCode::EXECUTOR_DOESNT_EXIST;
   }
 
-  std::shared_ptr<Executor> ExecutorDB::open_lease(int numcores, int memory, rfaas::LeaseResponse& lease)
+  ExecutorDB::node_iter_t ExecutorDB::_lease_node(node_iter_t it, std::shared_ptr<Executor> & node,
+      int numcores, int memory, rfaas::LeasedNode & leased)
+  {
+    leased.lease_id = _lease_count++;
+    leased.port = node->port;
+    leased.cores = numcores;
+    strncpy(leased.address, node->address.c_str(), Executor::ADDRESS_LENGTH);
+
+    bool is_total = node->is_fully_leased();
+    _leases.emplace(
+      std::piecewise_construct,
+      std::forward_as_tuple(leased.lease_id),
+      std::forward_as_tuple(numcores, memory, is_total, std::weak_ptr<Executor>{node})
+    );
+
+    return is_total ? _free_nodes.erase(it) : ++it;
+  }
+
+  std::vector<std::shared_ptr<Executor>> ExecutorDB::open_lease(int numcores, int memory, rfaas::LeaseResponse& lease)
   {
     // Obtain write access
     writer_lock_t lock(_mutex);
 
+    lease.nodes_count = 0;
+    std::vector<std::shared_ptr<Executor>> allocated;
+
     if(!_free_nodes.size()) {
       SPDLOG_DEBUG("No available executors!");
-      return nullptr;
+      return allocated;
     }
 
-    std::weak_ptr<Executor> used_node;
+    // Nodes that can be used for a lease split into parts.
+    std::vector<std::tuple<node_iter_t, std::shared_ptr<Executor>>> candidates;
+    int available_cores = 0;
 
     auto it = _free_nodes.begin();
     while(it != _free_nodes.end()) {
@@ -75,32 +99,46 @@ namespace rfaas { namespace resource_manager {
         continue;
       }
 
-      if(!shared_ptr->lease(numcores, memory)) {
-        ++it;
-        SPDLOG_DEBUG("Node {} cannot be used, not enough resources!", shared_ptr->node);
-        continue;
+      // Prefer a single node to avoid splitting the lease.
+      if(shared_ptr->lease(numcores, memory)) {
+        _lease_node(it, shared_ptr, numcores, memory, lease.nodes[0]);
+        lease.nodes_count = 1;
+        allocated.push_back(std::move(shared_ptr));
+        return allocated;
       }
 
-      lease.lease_id = _lease_count++;
-      lease.port = shared_ptr->port;
-      strncpy(lease.address, shared_ptr->address.c_str(), Executor::ADDRESS_LENGTH);
-
-      bool is_total = shared_ptr->is_fully_leased();
-      if(is_total) {
-        _free_nodes.erase(it);
+      if(shared_ptr->_free_cores > 0 && shared_ptr->_free_memory >= memory) {
+        if(candidates.size() < MAX_NODES_PER_LEASE) {
+          available_cores += shared_ptr->_free_cores;
+          candidates.emplace_back(it, shared_ptr);
+        }
+      } else {
+        SPDLOG_DEBUG("Node {} cannot be used, not enough resources!", shared_ptr->node);
       }
+      ++it;
+    }
+
+    if(available_cores < numcores) {
+      SPDLOG_DEBUG("Not enough resources across {} nodes for {} cores!", candidates.size(), numcores);
+      return allocated;
+    }
 
-      _leases.emplace(
-        std::piecewise_construct,
-        std::forward_as_tuple(lease.lease_id),
-        std::forward_as_tuple(numcores, memory, is_total, std::move(ptr))
-      );
+    // Each part of the lease must receive the requested memory.
+    int remaining = numcores;
+    for(auto & [node_it, node] : candidates) {
 
-      return shared_ptr;
+      int cores = std::min(remaining, node->_free_cores);
+      node->lease(cores, memory);
+      _lease_node(node_it, node, cores, memory, lease.nodes[lease.nodes_count++]);
+      SPDLOG_DEBUG("Node {} receives part of the lease with {} cores", node->node, cores);
 
+      allocated.push_back(node);
+      remaining -= cores;
+      if(!remaining)
+        break;
     }
 
-    return nullptr;
+    return allocated;
   }
 
   void ExecutorDB::close_lease(common::LeaseDeallocation & msg)
@@ -10,6 +10,7 @@
 #include <shared_mutex>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include <rfaas/allocation.hpp>
 #include <rfaas/resources.hpp>
@@ -37,10 +38,15 @@ namespace rfaas { namespace resource_manager {
     uint32_t _lease_count;
 
     std::list<std::weak_ptr<Executor>> _free_nodes;
+    typedef std::list<std::weak_ptr<Executor>>::iterator node_iter_t;
 
     // Reader-writer lock
     std::shared_mutex _mutex;
 
+    // Registers a part of the lease, returns the next free node.
+    node_iter_t _lease_node(node_iter_t it, std::shared_ptr<Executor> & node,
+        int numcores, int memory, rfaas::LeasedNode & leased);
+
   public:
     enum class ResultCode
     {
@@ -58,7 +64,8 @@ namespace rfaas { namespace resource_manager {
     ResultCode add(const std::string& node_name, const std::string & ip_address, int port, int cores, int memory);
     ResultCode remove(const std::string& node_name);
 
-    std::shared_ptr<Executor> open_lease(int numcores, int memory, rfaas::LeaseResponse& lease);
+    // The lease is split across several nodes when no single node has enough free cores.
+    std::vector<std::shared_ptr<Executor>> open_lease(int numcores, int memory, rfaas::LeaseResponse& lease);
 
     void close_lease(common::LeaseDeallocation & msg);
 
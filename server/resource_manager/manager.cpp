@@ -305,13 +305,16 @@ void Manager::_handle_client_message(ibv_wc& wc, std::vector<Client*>& poll_send
     );
 
     auto allocated = _executor_data.open_lease(cores, memory, *client.response().data());
-    if(allocated) {
-      spdlog::info("[Manager] Client receives lease with id {}", client.response().data()->lease_id);
+    if(!allocated.empty()) {
+      spdlog::info(
+        "[Manager] Client receives lease with id {} on {} nodes",
+        client.response().data()->nodes[0].lease_id, allocated.size()
+      );
     } else {
       spdlog::info("[Manager] Client request couldn't be satisfied");
     }
 
-    if(!allocated) {
+    if(allocated.empty()) {
       // FIXME: Send empty response?
       client.connection->post_send(
         client.response(),
@@ -321,23 +324,29 @@ void Manager::_handle_client_message(ibv_wc& wc, std::vector<Client*>& poll_send
       );
     } else {
 
-      allocated->_send_buffer[0].lease_id = client.response()[0].lease_id;
-      allocated->_send_buffer[0].cores = cores;
-      allocated->_send_buffer[0].memory = memory;
+      // Each node allocates its own part of the lease.
+      for(size_t i = 0; i < allocated.size(); ++i) {
 
-      allocated->_connection->post_send(
-        allocated->_send_buffer,
-        0,
-        allocated->_send_buffer.size() <= _device.max_inline_data,
-        1
-      );
-      allocated->_connection->poll_wc(rdmalib::QueueType::SEND, true, 1);
+        auto & node = client.response()[0].nodes[i];
+        allocated[i]->_send_buffer[0].lease_id = node.lease_id;
+        allocated[i]->_send_buffer[0].cores = node.cores;
+        allocated[i]->_send_buffer[0].memory = memory;
+
+        allocated[i]->_connection->post_send(
+          allocated[i]->_send_buffer,
+          0,
+          allocated[i]->_send_buffer.size() <= _device.max_inline_data,
+          1
+        );
+        allocated[i]->_connection->poll_wc(rdmalib::QueueType::SEND, true, 1);
+      }
 
+      // The immediate value contains the number of nodes.
       client.connection->post_send(
         client.response(),
         0,
         client.response().size() <= _device.max_inline_data,
-        1
+        static_cast<uint32_t>(allocated.size())
       );
     }
     poll_send.emplace_back(&client);
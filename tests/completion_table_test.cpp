@@ -0,0 +1,109 @@
+
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <rfaas/completions.hpp>
+
+#include <gtest/gtest.h>
+
+TEST(CompletionTableTest, InvalidCapacity) {
+  EXPECT_THROW(rfaas::completion_table{0}, std::invalid_argument);
+  EXPECT_THROW(rfaas::completion_table{3}, std::invalid_argument);
+  EXPECT_THROW(rfaas::completion_table{1 << 24}, std::invalid_argument);
+}
+
+// Slots become available again once the invocation and its future released them.
+TEST(CompletionTableTest, SlotReuse) {
+  rfaas::completion_table table{4};
+
+  std::vector<rfaas::future> futures;
+  std::vector<int> slots;
+  for(int i = 0; i < table.capacity(); ++i) {
+    int slot = table.acquire(1);
+    ASSERT_NE(slot, -1);
+    for(int prev : slots)
+      EXPECT_NE(slot, prev);
+    slots.push_back(slot);
+    futures.emplace_back(table.slot(slot));
+  }
+  EXPECT_EQ(table.acquire(1), -1);
+
+  EXPECT_TRUE(table.complete(slots[1], 0, 16));
+  table.resume(slots[1]);
+  EXPECT_EQ(futures[1].bytes(), 16u);
+  EXPECT_EQ(futures[1].get(), 0);
+
+  int slot = table.acquire(2);
+  EXPECT_EQ(slot, slots[1]);
+  EXPECT_EQ(table.acquire(1), -1);
+
+  // State of the previous invocation is cleared.
+  rfaas::future result{table.slot(slot)};
+  EXPECT_FALSE(result.is_ready());
+  EXPECT_EQ(result.bytes(), 0u);
+  EXPECT_FALSE(table.complete(slot, 0, 8));
+  EXPECT_TRUE(table.complete(slot, 0, 8));
+  table.resume(slot);
+  EXPECT_TRUE(result.is_ready());
+  EXPECT_EQ(result.get(), 0);
+}
+
+// The slot is held by the invocation and its future - either of them can release it first.
+TEST(CompletionTableTest, TwoReferenceRelease) {
+  rfaas::completion_table table{2};
+
+  int first = table.acquire(1);
+  int second = table.acquire(1);
+  ASSERT_NE(first, -1);
+  ASSERT_NE(second, -1);
+
+  // Future released first - the completion still arrives to the same slot.
+  {
+    rfaas::future result{table.slot(first)};
+  }
+  EXPECT_EQ(table.slot(first)->references.load(), 1);
+  EXPECT_EQ(table.acquire(1), -1);
+  EXPECT_TRUE(table.complete(first, 0, 0));
+  table.resume(first);
+  EXPECT_EQ(table.slot(first)->references.load(), 0);
+
+  // Invocation finished first - the result is kept until the future reads it.
+  rfaas::future result{table.slot(second)};
+  EXPECT_TRUE(table.complete(second, 5, 0));
+  table.resume(second);
+  EXPECT_EQ(table.slot(second)->references.load(), 1);
+  EXPECT_EQ(table.acquire(1), first);
+  EXPECT_EQ(table.acquire(1), -1);
+  EXPECT_EQ(result.get(), 5);
+  EXPECT_EQ(table.slot(second)->references.load(), 0);
+  EXPECT_EQ(table.acquire(1), second);
+}
+
+// A thread waiting for the result is parked on the futex and woken up by the last completion.
+TEST(CompletionTableTest, FutexParkWake) {
+  rfaas::completion_table table{2};
+  int slot = table.acquire(2);
+  ASSERT_NE(slot, -1);
+  rfaas::future result{table.slot(slot)};
+
+  int value = -1;
+  std::thread waiter{[&]() { value = result.get(); }};
+
+  // Wait until the thread stops spinning.
+  while(!table.slot(slot)->waiters.load())
+    std::this_thread::yield();
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  EXPECT_FALSE(table.complete(slot, 0, 4));
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  EXPECT_EQ(table.slot(slot)->waiters.load(), 1);
+
+  EXPECT_TRUE(table.complete(slot, 3, 4));
+  table.resume(slot);
+  waiter.join();
+  EXPECT_EQ(value, 3);
+  EXPECT_EQ(table.slot(slot)->waiters.load(), 0);
+  EXPECT_EQ(table.slot(slot)->references.load(), 0);
+}
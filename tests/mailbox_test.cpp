@@ -0,0 +1,77 @@
+
+#include <cstdint>
+#include <random>
+#include <thread>
+
+#include <infiniband/verbs.h>
+
+#include "executor/dispatcher.hpp"
+
+#include <gtest/gtest.h>
+
+static ibv_wc completion(uint64_t id)
+{
+  ibv_wc wc{};
+  wc.wr_id = id;
+  return wc;
+}
+
+// Completions are returned in order after the indices wrap around the ring many times.
+TEST(MailboxTest, WrapAround) {
+  // Rounded up to four entries.
+  server::Mailbox mailbox{3};
+  ibv_wc wcs[4];
+
+  uint64_t pushed = 0, popped = 0;
+  for(int round = 0; round < 1000; ++round) {
+
+    while(mailbox.push(completion(pushed)))
+      ++pushed;
+    EXPECT_EQ(pushed - popped, 4u);
+
+    // Leave some completions behind to shift the position of the head.
+    int count = round % 4 + 1;
+    while(count > 0) {
+      int ret = mailbox.pop(wcs, count);
+      ASSERT_GT(ret, 0);
+      for(int i = 0; i < ret; ++i)
+        EXPECT_EQ(wcs[i].wr_id, popped++);
+      count -= ret;
+    }
+  }
+}
+
+// The worker goes to sleep between bursts of the dispatcher, and it has to be woken up
+// by each of them. A lost wakeup hangs the test.
+TEST(MailboxTest, StressLostWakeup) {
+  constexpr uint64_t COMPLETIONS = 1000000;
+  server::Mailbox mailbox{8};
+
+  std::thread producer{[&]() {
+    std::mt19937 gen{42};
+    std::uniform_int_distribution<int> burst{1, 12};
+    // Pauses around the spin limit of the worker, so it's caught both spinning and sleeping.
+    std::uniform_int_distribution<int> pause{0, 2 * server::Mailbox::SPIN_ITERATIONS};
+    uint64_t pushed = 0;
+    while(pushed < COMPLETIONS) {
+      for(int i = burst(gen); i > 0 && pushed < COMPLETIONS; --i) {
+        while(!mailbox.push(completion(pushed)))
+          std::this_thread::yield();
+        ++pushed;
+      }
+      for(volatile int i = pause(gen); i > 0; --i);
+    }
+  }};
+
+  ibv_wc wcs[4];
+  uint64_t popped = 0;
+  bool ordered = true;
+  while(popped < COMPLETIONS) {
+    int ret = mailbox.pop(wcs, 4);
+    for(int i = 0; i < ret; ++i)
+      ordered &= wcs[i].wr_id == popped++;
+  }
+  producer.join();
+  EXPECT_TRUE(ordered);
+  EXPECT_EQ(popped, COMPLETIONS);
+}
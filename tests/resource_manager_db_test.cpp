@@ -0,0 +1,87 @@
+
+#include <cstring>
+#include <string>
+
+#include <rdmalib/connection.hpp>
+#include <rfaas/allocation.hpp>
+
+#include "resource_manager/db.hpp"
+
+#include <gtest/gtest.h>
+
+using rfaas::resource_manager::ExecutorDB;
+
+class ExecutorDBTest : public ::testing::Test {
+
+protected:
+  static constexpr int MEMORY = 1024;
+
+  // Leases are given only to connected executors - the connection itself is never used.
+  rdmalib::Connection _connection{1};
+  rfaas::resource_manager::Executors _executors{nullptr};
+  ExecutorDB _db{_executors};
+  rfaas::LeaseResponse _lease;
+
+  void add(const std::string & name, const std::string & address, int cores)
+  {
+    ASSERT_EQ(_db.add(name, address, 10000, cores, MEMORY), ExecutorDB::ResultCode::OK);
+    _executors.get_executor(name)->_connection = &_connection;
+  }
+
+  int free_cores(const std::string & name)
+  {
+    return _executors.get_executor(name)->_free_cores;
+  }
+};
+
+TEST_F(ExecutorDBTest, SingleNodePreference) {
+  add("small", "192.168.0.1", 2);
+  add("large", "192.168.0.2", 8);
+
+  auto nodes = _db.open_lease(4, 1, _lease);
+  ASSERT_EQ(nodes.size(), 1u);
+  ASSERT_EQ(_lease.nodes_count, 1);
+  EXPECT_EQ(nodes[0]->node, "large");
+  EXPECT_EQ(_lease.nodes[0].cores, 4);
+  EXPECT_EQ(_lease.nodes[0].port, 10000);
+  EXPECT_STREQ(_lease.nodes[0].address, "192.168.0.2");
+  EXPECT_EQ(free_cores("small"), 2);
+  EXPECT_EQ(free_cores("large"), 4);
+}
+
+TEST_F(ExecutorDBTest, SplitAcrossNodes) {
+  add("first", "192.168.0.1", 2);
+  add("second", "192.168.0.2", 3);
+
+  auto nodes = _db.open_lease(4, 1, _lease);
+  ASSERT_EQ(nodes.size(), 2u);
+  ASSERT_EQ(_lease.nodes_count, 2);
+  EXPECT_EQ(_lease.nodes[0].cores + _lease.nodes[1].cores, 4);
+  EXPECT_NE(_lease.nodes[0].lease_id, _lease.nodes[1].lease_id);
+  EXPECT_STREQ(_lease.nodes[0].address, "192.168.0.1");
+  EXPECT_EQ(_lease.nodes[0].cores, 2);
+  EXPECT_STREQ(_lease.nodes[1].address, "192.168.0.2");
+  EXPECT_EQ(_lease.nodes[1].cores, 2);
+  EXPECT_EQ(free_cores("first"), 0);
+  EXPECT_EQ(free_cores("second"), 1);
+
+  // The fully leased node is no longer considered.
+  nodes = _db.open_lease(1, 1, _lease);
+  ASSERT_EQ(_lease.nodes_count, 1);
+  EXPECT_EQ(nodes[0]->node, "second");
+  EXPECT_EQ(free_cores("second"), 0);
+}
+
+TEST_F(ExecutorDBTest, NotEnoughCores) {
+  add("first", "192.168.0.1", 2);
+  add("second", "192.168.0.2", 1);
+  // Not connected yet - its cores are not available.
+  ASSERT_EQ(_db.add("third", "192.168.0.3", 10000, 8, MEMORY), ExecutorDB::ResultCode::OK);
+
+  auto nodes = _db.open_lease(4, 1, _lease);
+  EXPECT_TRUE(nodes.empty());
+  EXPECT_EQ(_lease.nodes_count, 0);
+  EXPECT_EQ(free_cores("first"), 2);
+  EXPECT_EQ(free_cores("second"), 1);
+  EXPECT_EQ(free_cores("third"), 8);
+}